@@ -0,0 +1,246 @@
+/*
+** $Id: aot.c $
+** write chunks as C code (see laot.h)
+** See Copyright Notice in lua.h
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define luac_c
+#define LUA_CORE
+
+#include "ldebug.h"
+#include "lobject.h"
+#include "lopcodes.h"
+#include "lundump.h"
+
+#define CHECK	1			/* starts with a hook check */
+#define DATA	2			/* not an instruction */
+
+static int nfunctions;			/* functions written so far */
+
+static void RK(FILE* D, int x)
+{
+ if (ISK(x)) fprintf(D,"AK(%d)",INDEXK(x)); else fprintf(D,"AR(%d)",x);
+}
+
+/*
+** mark the data words and the instructions that check for hooks on entry:
+** targets of backward jumps and of tests (see ljit.c)
+*/
+static char* Scan(const Proto* f)
+{
+ const Instruction* code=f->code;
+ int n=f->sizecode;
+ char* flags=calloc(n+1,1);
+ int pc;
+ if (flags==NULL) return NULL;
+ for (pc=0; pc<n; pc++)
+ {
+  Instruction i=code[pc];
+  switch (GET_OPCODE(i))
+  {
+   case OP_JMP:
+	if (GETARG_sBx(i)<0) flags[pc+1+GETARG_sBx(i)]|=CHECK;
+	break;
+   case OP_FORLOOP:
+   case OP_FORPREP:
+	flags[pc+1+GETARG_sBx(i)]|=CHECK;
+	break;
+   case OP_EQ: case OP_LT: case OP_LE: case OP_EQK:
+   case OP_TEST: case OP_TESTSET: case OP_TFORLOOP:
+	flags[pc+2]|=CHECK;
+	flags[pc+2+GETARG_sBx(code[pc+1])]|=CHECK;
+	break;
+   case OP_SETLIST:
+	if (GETARG_C(i)==0) flags[++pc]|=DATA;
+	break;
+   case OP_CLOSURE:
+   {
+	int nup=f->p[GETARG_Bx(i)]->nups;
+	while (nup--) flags[++pc]|=DATA;
+	break;
+   }
+   default:
+	break;
+  }
+ }
+ return flags;
+}
+
+static void WriteInstruction(const Proto* f, int pc, FILE* D)
+{
+ static const char* const ops[]={"add","sub","mul","div","mod","pow"};
+ static const char* const iops[]={"intadd","intsub","intmul","intnone","intmod","intnone"};
+ Instruction i=f->code[pc];
+ OpCode o=GET_OPCODE(i);
+ int a=GETARG_A(i);
+ int b=GETARG_B(i);
+ int c=GETARG_C(i);
+ int bx=GETARG_Bx(i);
+ int sbx=GETARG_sBx(i);
+ unsigned long ui=(unsigned long)i;
+ int t=0,e=pc+2;			/* targets of a test */
+ if (testTMode(o) || o==OP_TFORLOOP) t=pc+2+GETARG_sBx(f->code[pc+1]);
+ switch (o)
+ {
+  case OP_MOVE:
+	fprintf(D,"aot_move(%d,%d);",a,b);
+	break;
+  case OP_LOADK:
+	fprintf(D,"aot_loadk(%d,%d);",a,bx);
+	break;
+  case OP_LOADBOOL:
+	fprintf(D,"aot_loadbool(%d,%d);",a,b);
+	if (c) fprintf(D," goto L%d;",pc+2);
+	break;
+  case OP_LOADNIL:
+	fprintf(D,"aot_loadnil(%d,%d);",a,b);
+	break;
+  case OP_GETUPVAL:
+	fprintf(D,"aot_getupval(%d,%d);",a,b);
+	break;
+  case OP_NOT:
+	fprintf(D,"aot_not(%d,%d);",a,b);
+	break;
+  case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV: case OP_MOD: case OP_POW:
+	fprintf(D,"aot_arith(%d,",a); RK(D,b); fprintf(D,","); RK(D,c);
+	fprintf(D,",luai_num%s,%s,0x%08lX,%d)",ops[o-OP_ADD],iops[o-OP_ADD],ui,pc);
+	break;
+  case OP_ADDK: case OP_SUBK:
+	fprintf(D,"aot_arith(%d,AR(%d),",a,b); RK(D,c);
+	fprintf(D,",luai_num%s,%s,0x%08lX,%d)",ops[o==OP_ADDK ? 0 : 1],
+		iops[o==OP_ADDK ? 0 : 1],ui,pc);
+	break;
+  case OP_JMP:
+	fprintf(D,"goto L%d;",pc+1+sbx);
+	break;
+  case OP_EQ:
+	fprintf(D,"aot_eq("); RK(D,b); fprintf(D,","); RK(D,c);
+	fprintf(D,",0x%08lX,%d,%d,L%d,L%d)",ui,pc,a,t,e);
+	break;
+  case OP_LT: case OP_LE:
+	fprintf(D,"aot_order("); RK(D,b); fprintf(D,","); RK(D,c);
+	fprintf(D,",%s,luai_num%s,luaV_op%s,0x%08lX,%d,%d,L%d,L%d)",
+		o==OP_LT ? "<" : "<=",o==OP_LT ? "lt" : "le",o==OP_LT ? "lt" : "le",
+		ui,pc,a,t,e);
+	break;
+  case OP_EQK:
+	fprintf(D,"aot_eqk(%d,%d,%d,L%d,L%d)",b,INDEXK(c),a,t,e);
+	break;
+  case OP_TEST:
+	fprintf(D,"aot_test(%d,%d,L%d,L%d)",a,c,t,e);
+	break;
+  case OP_TESTSET:
+	fprintf(D,"aot_testset(%d,%d,%d,L%d,L%d)",a,b,c,t,e);
+	break;
+  case OP_FORLOOP:
+	fprintf(D,"aot_forloop(%d,L%d)",a,pc+1+sbx);
+	break;
+  case OP_FORPREP:
+	fprintf(D,"aot_call(luaV_opforprep,0x%08lX,%d) goto L%d;",ui,pc,pc+1+sbx);
+	break;
+  case OP_TFORLOOP:
+	fprintf(D,"aot_cond(luaV_optforloop,0x%08lX,%d,1,L%d,L%d)",ui,pc,t,e);
+	break;
+  case OP_SETLIST:
+	fprintf(D,"aot_call(luaV_opsetlist,0x%08lX,%d)",ui,pc);
+	if (c==0)
+	 fprintf(D," aot_hook(%d) goto L%d;",pc+2,pc+2);
+	else
+	 fprintf(D," aot_hook(%d)",pc+1);
+	break;
+  case OP_GETGLOBAL: case OP_GETTABLE: case OP_SETGLOBAL: case OP_SETUPVAL:
+  case OP_SETTABLE: case OP_NEWTABLE: case OP_SELF: case OP_UNM:
+  case OP_LEN: case OP_CONCAT: case OP_CLOSE:
+  {
+	const char* name=(o==OP_UNM) ? "arith" : luaP_opnames[o];
+	fprintf(D,"aot_op(luaV_op");
+	for (; *name; name++) fputc(*name>='A' && *name<='Z' ? *name-'A'+'a' : *name,D);
+	fprintf(D,",0x%08lX,%d)",ui,pc);
+	break;
+  }
+  case OP_CALL:
+	if (b!=0 && c!=0)
+	{
+	 fprintf(D,"aot_fastcall(0x%08lX,%d)",ui,pc);
+	 break;
+	}
+	/* else go through */
+  default:				/* calls, returns, closures, varargs */
+	fprintf(D,"aot_exit(%d);",pc);
+	break;
+ }
+}
+
+static int WriteFunction(const Proto* f, FILE* D)
+{
+ int n=nfunctions++;
+ char* flags=Scan(f);
+ int pc,j;
+ if (flags==NULL) return -1;
+ fprintf(D,"\n/* %s:%d */\n",
+	(f->source==NULL) ? "=?" : getstr(f->source),f->linedefined);
+ fprintf(D,"static const Instruction *aot_%d (lua_State *L, const Instruction *pc) {\n",n);
+ fprintf(D," aot_begin;\n switch (pc - code) {\n");
+ for (pc=0; pc<f->sizecode; pc++)
+  if (!(flags[pc]&DATA)) fprintf(D,"  case %d: goto L%d;\n",pc,pc);
+ fprintf(D,"  default: return pc;\n }\n");
+ for (pc=0; pc<f->sizecode; pc++)
+ {
+  if (flags[pc]&DATA) continue;
+  fprintf(D," L%d: ",pc);
+  if (flags[pc]&CHECK) fprintf(D,"aot_hook(%d) ",pc);
+  WriteInstruction(f,pc,D);
+  fprintf(D,"\n");
+ }
+ fprintf(D,"}\n");
+ free(flags);
+ for (j=0; j<f->sizep; j++)
+  if (WriteFunction(f->p[j],D)!=0) return -1;
+ return 0;
+}
+
+static void WriteSizes(const Proto* f, FILE* D)
+{
+ int j;
+ fprintf(D," %d,",f->sizecode);
+ for (j=0; j<f->sizep; j++) WriteSizes(f->p[j],D);
+}
+
+#define Name(D,name)	{ const char* s; \
+	for (s=name; *s; s++) fputc(*s=='.' ? '_' : *s,D); }
+
+/*
+** write chunk f, which dumps as the given bytes, as the C code of module
+** `name'
+*/
+void luaU_aot(const Proto* f, const char* name, const char* chunk, size_t size, FILE* D)
+{
+ size_t i;
+ int j;
+ nfunctions=0;
+ fprintf(D,"/* module " LUA_QS " generated by luac -c */\n\n"
+	"#define LUA_CORE\n\n#include \"laot.h\"\n",name);
+ if (WriteFunction(f,D)!=0)
+ {
+  fprintf(stderr,"luac: not enough memory\n");
+  exit(EXIT_FAILURE);
+ }
+ fprintf(D,"\nstatic const AOTFunction aot_functions[] = {");
+ for (j=0; j<nfunctions; j++) fprintf(D,"%s aot_%d,",(j%8==0) ? "\n" : "",j);
+ fprintf(D,"\n};\n\nstatic const int aot_sizecode[] = {\n");
+ WriteSizes(f,D);
+ fprintf(D,"\n};\n\nstatic const unsigned char aot_chunk[] = {");
+ for (i=0; i<size; i++)
+  fprintf(D,"%s%u,",(i%16==0) ? "\n " : "",(unsigned char)chunk[i]);
+ fprintf(D,"\n};\n\n");
+ fprintf(D,"int luaopen_"); Name(D,name); fprintf(D," (lua_State *L) {\n");
+ fprintf(D," if (luaL_loadbuffer(L, (const char *)aot_chunk, sizeof(aot_chunk),"
+	" \"=%s\") != 0)\n  return lua_error(L);\n",name);
+ fprintf(D," luaU_setaot(clvalue(L->top - 1)->l.p, aot_functions, aot_sizecode,"
+	" %d);\n",nfunctions);
+ fprintf(D," lua_insert(L, 1);\n lua_call(L, lua_gettop(L) - 1, 1);\n"
+	" return 1;\n}\n");
+}
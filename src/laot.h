@@ -0,0 +1,190 @@
+/*
+** $Id: laot.h $
+** Support for C code generated by "luac -c"
+** See Copyright Notice in lua.h
+*/
+
+#ifndef laot_h
+#define laot_h
+
+
+/*
+** "luac -c name" turns a chunk into a C file. Each function of the
+** chunk becomes a C function (an `AOTFunction') that runs its
+** instructions with the macros below; `luaopen_name' loads the chunk
+** (which the file also holds as bytecode), attaches those C functions to
+** it (`luaU_setaot') and runs it, like `require' runs a Lua module. The
+** file must be compiled with the same luaconf.h as the core, and linked
+** with it statically; it can then be put into `package.preload'.
+**
+** `luaV_execute' calls the C function of a Lua function on entry, after
+** calls and on backward jumps (see `vmnative'); the C function goes on
+** from `pc' and returns where the interpreter must continue. Calls,
+** returns, closures and varargs are left to the interpreter (but for
+** calls it can make without a CallInfo, see `aot_fastcall'), and so is
+** everything while line or count hooks are on.
+*/
+
+#include "lua.h"
+#include "lauxlib.h"
+
+#include "ldebug.h"
+#include "ldo.h"
+#include "lfunc.h"
+#include "lgc.h"
+#include "lobject.h"
+#include "lopcodes.h"
+#include "lstate.h"
+#include "ltable.h"
+#include "ltm.h"
+#include "lundump.h"
+#include "lvm.h"
+
+
+/* state of a generated function (the first thing in its body) */
+#define aot_begin	\
+  LClosure *cl = &clvalue(L->ci->func)->l; \
+  const Instruction *const code = cl->p->code; \
+  TValue *const k = cl->p->k; \
+  StkId base = L->base; \
+  UNUSED(k); UNUSED(base)
+
+#define AR(x)	(base+(x))
+#define AK(x)	(k+(x))
+
+
+/* go back to the interpreter at instruction `n' */
+#define aot_exit(n)	return code + (n)
+
+#define aot_hook(n)	\
+  { if (L->hookmask & (LUA_MASKLINE | LUA_MASKCOUNT)) aot_exit(n); }
+
+/* instruction `i' at `n' done out of line (see `luaV_opgettable' & co.) */
+#define aot_call(f,i,n)	\
+  { L->savedpc = code + (n) + 1; (void)f(L, i); base = L->base; }
+
+#define aot_op(f,i,n)	{ aot_call(f, i, n) aot_hook((n) + 1) }
+
+/*
+** OP_CALL, when the builtin called can be computed or the C function
+** called without a CallInfo (see `luaV_opcall'); else the interpreter
+** makes the call
+*/
+#define aot_fastcall(i,n)	{ \
+  L->savedpc = code + (n) + 1; \
+  if (!luaV_opcall(L, i)) aot_exit(n); \
+  base = L->base; }
+
+/* a test done out of line: goes to `t' when it gives `a', else to `e' */
+#define aot_cond(f,i,n,a,t,e)	{ \
+  int c_; \
+  L->savedpc = code + (n) + 1; \
+  c_ = f(L, i); \
+  base = L->base; \
+  if (c_ == (a)) goto t; \
+  goto e; }
+
+
+#define aot_move(a,b)	setobjs2s(L, AR(a), AR(b))
+
+#define aot_loadk(a,bx)	setobj2s(L, AR(a), AK(bx))
+
+#define aot_loadbool(a,b)	setbvalue(AR(a), b)
+
+#define aot_loadnil(a,b)	{ \
+  StkId ra_ = AR(a); \
+  StkId rb_ = AR(b); \
+  do { setnilvalue(rb_--); } while (rb_ >= ra_); }
+
+#define aot_getupval(a,b)	setobj2s(L, AR(a), cl->upvals[b]->v)
+
+#define aot_not(a,b)	{ int r_ = l_isfalse(AR(b)); setbvalue(AR(a), r_); }
+
+
+/* like `arith_op' in lvm.c; `iop' is one of `intadd' & co. (see lvm.h) */
+#define aot_arith(a,b,c,op,iop,i,n)	{ \
+  const TValue *rb_ = (b); \
+  const TValue *rc_ = (c); \
+  int r_; \
+  if (ttisint(rb_) && ttisint(rc_) && iop(ivalue(rb_), ivalue(rc_), r_)) { \
+    setivalue(AR(a), r_); \
+  } \
+  else if (ttisnumber(rb_) && ttisnumber(rc_)) { \
+    setnvalue(AR(a), op(nvalue(rb_), nvalue(rc_))); \
+  } \
+  else aot_op(luaV_oparith, i, n) }
+
+
+/* LT and LE: numbers inline, the rest through `luaV_lessthan' & co. */
+#define aot_order(b,c,iop,op,f,i,n,a,t,e)	{ \
+  const TValue *rb_ = (b); \
+  const TValue *rc_ = (c); \
+  if (ttisint(rb_) && ttisint(rc_)) { \
+    if ((ivalue(rb_) iop ivalue(rc_)) == (a)) goto t; \
+    goto e; \
+  } \
+  else if (ttisnumber(rb_) && ttisnumber(rc_)) { \
+    if (op(nvalue(rb_), nvalue(rc_)) == (a)) goto t; \
+    goto e; \
+  } \
+  else aot_cond(f, i, n, a, t, e) }
+
+#define aot_eq(b,c,i,n,a,t,e)	{ \
+  const TValue *rb_ = (b); \
+  const TValue *rc_ = (c); \
+  if (ttisint(rb_) && ttisint(rc_)) { \
+    if ((ivalue(rb_) == ivalue(rc_)) == (a)) goto t; \
+    goto e; \
+  } \
+  else aot_cond(luaV_opeq, i, n, a, t, e) }
+
+/* constants have no metatables, so this is a raw equality */
+#define aot_eqk(b,c,a,t,e)	{ \
+  const TValue *rb_ = AR(b); \
+  const TValue *rc_ = AK(c); \
+  if ((ttisint(rb_) && ttisint(rc_) ? ivalue(rb_) == ivalue(rc_) : \
+       ttype(rb_) == ttype(rc_) && \
+       (ttisnumber(rb_) ? luai_numeq(nvalue(rb_), nvalue(rc_)) \
+                        : luaO_rawequalObj(rb_, rc_))) == (a)) goto t; \
+  goto e; }
+
+#define aot_test(a,c,t,e)	{ \
+  if (l_isfalse(AR(a)) != (c)) goto t; \
+  goto e; }
+
+#define aot_testset(a,b,c,t,e)	{ \
+  const TValue *rb_ = AR(b); \
+  if (l_isfalse(rb_) != (c)) { \
+    setobjs2s(L, AR(a), rb_); \
+    goto t; \
+  } \
+  goto e; }
+
+
+/* like OP_FORLOOP in lvm.c */
+#define aot_forloop(a,t)	{ \
+  StkId ra_ = AR(a); \
+  if (ttisint(ra_)) { \
+    int step_ = ivalue(ra_+2); \
+    int idx_; \
+    if (intadd(ivalue(ra_), step_, idx_) && \
+        (0 < step_ ? idx_ <= ivalue(ra_+1) : ivalue(ra_+1) <= idx_)) { \
+      setivalue(ra_, idx_); \
+      setivalue(ra_+3, idx_); \
+      goto t; \
+    } \
+  } \
+  else { \
+    lua_Number step_ = fltvalue(ra_+2); \
+    lua_Number idx_ = luai_numadd(fltvalue(ra_), step_); \
+    lua_Number limit_ = fltvalue(ra_+1); \
+    if (luai_numlt(0, step_) ? luai_numle(idx_, limit_) \
+                             : luai_numle(limit_, idx_)) { \
+      setnvalue(ra_, idx_); \
+      setnvalue(ra_+3, idx_); \
+      goto t; \
+    } \
+  } }
+
+
+#endif
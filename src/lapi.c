@@ -348,7 +348,9 @@ LUA_API lua_Number lua_tonumber (lua_State *L, int idx) {
 LUA_API lua_Integer lua_tointeger (lua_State *L, int idx) {
   TValue n;
   const TValue *o = index2adr(L, idx);
-  if (tonumber(o, &n)) {
+  if (ttisint(o))
+    return ivalue(o);
+  else if (tonumber(o, &n)) {
     lua_Integer res;
     lua_Number num = nvalue(o);
     lua_number2integer(res, num);
@@ -461,7 +463,12 @@ LUA_API void lua_pushnumber (lua_State *L, lua_Number n) {
 
 LUA_API void lua_pushinteger (lua_State *L, lua_Integer n) {
   lua_lock(L);
-  setnvalue(L->top, cast_num(n));
+  if (cast(lua_Integer, cast_int(n)) == n) {
+    setivalue(L->top, cast_int(n));
+  }
+  else {
+    setnvalue(L->top, cast_num(n));
+  }
   api_incr_top(L);
   lua_unlock(L);
 }
@@ -724,7 +731,7 @@ LUA_API void lua_rawseti (lua_State *L, int idx, int n) {
   api_checknelems(L, 1);
   o = index2adr(L, idx);
   api_check(L, ttistable(o));
-  setobj2t(L, luaH_setnum(L, hvalue(o), n), L->top-1);
+  luaH_setint(L, hvalue(o), n, L->top-1);
   luaC_barriert(L, hvalue(o), L->top-1);
   L->top--;
   lua_unlock(L);
@@ -743,9 +750,12 @@ LUA_API int lua_setmetatable (lua_State *L, int objindex) {
   else {
     api_check(L, ttistable(L->top - 1));
     mt = hvalue(L->top - 1);
+    if (mt->tmcache == NULL)
+      luaT_newcache(L, mt);
   }
   switch (ttype(obj)) {
     case LUA_TTABLE: {
+      luaV_touch(L, hvalue(obj));
       hvalue(obj)->metatable = mt;
       if (mt)
         luaC_objbarriert(L, hvalue(obj), mt);
@@ -768,6 +778,118 @@ LUA_API int lua_setmetatable (lua_State *L, int objindex) {
 }
 
 
+/*
+** gives the C function at `idx' a fast version for calls from Lua with
+** exactly `nargs' arguments, which OP_CALL makes without a CallInfo
+** (see `fastcall' in lvm.c). `fast' finds the arguments at 1..nargs
+** and either pushes one result and returns 1, or returns 0 to have the
+** ordinary function called instead (to raise an error, say). So it
+** must not raise errors, allocate memory, call Lua or use pseudo-indices.
+*/
+LUA_API void lua_setfastcfunction (lua_State *L, int idx, lua_CFunction fast,
+                                   int nargs) {
+  StkId o;
+  lua_lock(L);
+  o = index2adr(L, idx);
+  api_check(L, iscfunction(o));
+  api_check(L, nargs >= 0);
+  clvalue(o)->c.fastf = fast;
+  clvalue(o)->c.fastnargs = nargs;
+  lua_unlock(L);
+}
+
+
+/*
+** removes every entry of the table at `idx' (raw, without metamethods),
+** keeping the memory it has for its entries
+*/
+LUA_API void lua_cleartable (lua_State *L, int idx) {
+  StkId t;
+  lua_lock(L);
+  t = index2adr(L, idx);
+  api_check(L, ttistable(t));
+  luaH_clear(L, hvalue(t));
+  lua_unlock(L);
+}
+
+
+/*
+** shrinks the table at `idx' to the entries it has (raw); it must not be
+** done while traversing that table
+*/
+LUA_API void lua_compacttable (lua_State *L, int idx) {
+  StkId t;
+  lua_lock(L);
+  t = index2adr(L, idx);
+  api_check(L, ttistable(t));
+  luaH_compact(L, hvalue(t));
+  lua_unlock(L);
+}
+
+
+/*
+** makes the table at `idx' read-only: later writes to it, raw or not,
+** and changes of its metatable raise errors
+*/
+LUA_API void lua_freezetable (lua_State *L, int idx) {
+  StkId t;
+  lua_lock(L);
+  t = index2adr(L, idx);
+  api_check(L, ttistable(t));
+  luaH_freeze(L, hvalue(t));
+  lua_unlock(L);
+}
+
+
+/*
+** declares that the C function at `idx' behaves as `next' (LUA_ITERNEXT)
+** or as the iterator of `ipairs' (LUA_ITERIPAIRS), so that generic `for'
+** loops do its steps inline over tables instead of calling it (see
+** `tforloop' in lvm.c); 0 undoes it
+*/
+LUA_API void lua_setiterator (lua_State *L, int idx, int kind) {
+  StkId o;
+  lua_lock(L);
+  o = index2adr(L, idx);
+  api_check(L, iscfunction(o));
+  api_check(L, 0 <= kind && kind <= LUA_ITERIPAIRS);
+  clvalue(o)->c.iter = cast_byte(kind);
+  lua_unlock(L);
+}
+
+
+/*
+** declares that the C function at `idx' is the builtin `kind'
+** (LUA_INTRABS & co.), so that OP_CALL computes calls of it inline, with
+** no call at all, when they pass the arguments that builtin takes
+** (see `intrinsic' in lvm.c); any other call still calls it. 0 undoes it
+*/
+LUA_API void lua_setintrinsic (lua_State *L, int idx, int kind) {
+  StkId o;
+  lua_lock(L);
+  o = index2adr(L, idx);
+  api_check(L, iscfunction(o));
+  api_check(L, 0 <= kind && kind <= LUA_INTRBYTE);
+  clvalue(o)->c.intrinsic = cast_byte(kind);
+  lua_unlock(L);
+}
+
+
+/*
+** pushes a shallow copy of the table at `idx' (raw, sharing its metatable)
+*/
+LUA_API void lua_clonetable (lua_State *L, int idx) {
+  StkId t;
+  lua_lock(L);
+  luaC_checkGC(L);
+  t = index2adr(L, idx);
+  api_check(L, ttistable(t));
+  sethvalue(L, L->top, luaH_clone(L, hvalue(t)));
+  api_incr_top(L);
+  lua_unlock(L);
+}
+
+
 LUA_API int lua_setfenv (lua_State *L, int idx) {
   StkId o;
   int res = 1;
@@ -283,6 +283,21 @@ LUALIB_API void luaI_openlib (lua_State *L, const char *libname,
 }
 
 
+/*
+** gives functions of the library at the top their fast versions (see
+** `lua_setfastcfunction') and marks the builtins among them (see
+** `lua_setintrinsic')
+*/
+LUALIB_API void luaL_setfast (lua_State *L, const luaL_RegFast *l) {
+  for (; l->name; l++) {
+    lua_getfield(L, -1, l->name);
+    lua_setfastcfunction(L, -1, l->func, l->nargs);
+    if (l->intrinsic) lua_setintrinsic(L, -1, l->intrinsic);
+    lua_pop(L, 1);
+  }
+}
+
+
 
 /*
 ** {======================================================
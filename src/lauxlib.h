@@ -38,11 +38,20 @@ typedef struct luaL_Reg {
 } luaL_Reg;
 
 
+typedef struct luaL_RegFast {
+  const char *name;
+  lua_CFunction func;
+  int nargs;
+  int intrinsic;
+} luaL_RegFast;
+
+
 
 LUALIB_API void (luaI_openlib) (lua_State *L, const char *libname,
                                 const luaL_Reg *l, int nup);
 LUALIB_API void (luaL_register) (lua_State *L, const char *libname,
                                 const luaL_Reg *l);
+LUALIB_API void (luaL_setfast) (lua_State *L, const luaL_RegFast *l);
 LUALIB_API int (luaL_getmetafield) (lua_State *L, int obj, const char *e);
 LUALIB_API int (luaL_callmeta) (lua_State *L, int obj, const char *e);
 LUALIB_API int (luaL_typerror) (lua_State *L, int narg, const char *tname);
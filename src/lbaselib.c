@@ -174,6 +174,21 @@ static int luaB_rawget (lua_State *L) {
   return 1;
 }
 
+/* fast versions of `rawequal' and `rawget' (see `lua_setfastcfunction') */
+static int fast_rawequal (lua_State *L) {
+  lua_pushboolean(L, lua_rawequal(L, 1, 2));
+  return 1;
+}
+
+
+static int fast_rawget (lua_State *L) {
+  if (lua_type(L, 1) != LUA_TTABLE) return 0;
+  lua_pushvalue(L, 2);
+  lua_rawget(L, 1);
+  return 1;
+}
+
+
 static int luaB_rawset (lua_State *L) {
   luaL_checktype(L, 1, LUA_TTABLE);
   luaL_checkany(L, 2);
@@ -473,6 +488,13 @@ static const luaL_Reg base_funcs[] = {
 };
 
 
+static const luaL_RegFast base_fast[] = {
+  {"rawequal", fast_rawequal, 2, 0},
+  {"rawget", fast_rawget, 2, 0},
+  {NULL, NULL, 0, 0}
+};
+
+
 /*
 ** {======================================================
 ** Coroutine library
@@ -632,8 +654,9 @@ static const luaL_Reg co_funcs[] = {
 
 
 static void auxopen (lua_State *L, const char *name,
-                     lua_CFunction f, lua_CFunction u) {
+                     lua_CFunction f, lua_CFunction u, int iter) {
   lua_pushcfunction(L, u);
+  lua_setiterator(L, -1, iter);
   lua_pushcclosure(L, f, 1);
   lua_setfield(L, -2, name);
 }
@@ -647,12 +670,16 @@ static void base_open (lua_State *L) {
   /* open lib into global table */
   // 将base_funcs中的函数全都放入_G表中
   luaL_register(L, "_G", base_funcs);
+  luaL_setfast(L, base_fast);
+  lua_getfield(L, -1, "next");
+  lua_setiterator(L, -1, LUA_ITERNEXT);
+  lua_pop(L, 1);
   // 存放版本号
   lua_pushliteral(L, LUA_VERSION);
   lua_setglobal(L, "_VERSION");  /* set global _VERSION */
   /* `ipairs' and `pairs' need auxliliary functions as upvalues */
-  auxopen(L, "ipairs", luaB_ipairs, ipairsaux);
-  auxopen(L, "pairs", luaB_pairs, luaB_next);
+  auxopen(L, "ipairs", luaB_ipairs, ipairsaux, LUA_ITERIPAIRS);
+  auxopen(L, "pairs", luaB_pairs, luaB_next, LUA_ITERNEXT);
   /* `newproxy' needs a weaktable as upvalue */
   lua_createtable(L, 0, 1);  /* new table `w' */
   lua_pushvalue(L, -1);  /* `w' will be its own metatable */
@@ -283,8 +283,8 @@ int luaK_stringK (FuncState *fs, TString *s) {
 // 向FuncState添加一个数字常量
 int luaK_numberK (FuncState *fs, lua_Number r) {
   TValue o;
-  setnvalue(&o, r); 
- return addk(fs, &o, &o);
+  setnumvalue(&o, r);
+  return addk(fs, &o, &o);
 }
 
 // 添加一个BOOL类型常量
@@ -724,6 +724,7 @@ static void codearith (FuncState *fs, OpCode op, expdesc *e1, expdesc *e2) {
   if (constfolding(op, e1, e2))
     return;
   else {
+    int knum = (op == OP_ADD || op == OP_SUB) && isnumeral(e2);
     int o2 = (op != OP_UNM && op != OP_LEN) ? luaK_exp2RK(fs, e2) : 0;
     int o1 = luaK_exp2RK(fs, e1);
     if (o1 > o2) {
@@ -734,6 +735,8 @@ static void codearith (FuncState *fs, OpCode op, expdesc *e1, expdesc *e2) {
       freeexp(fs, e2);
       freeexp(fs, e1);
     }
+    if (knum && ISK(o2) && !ISK(o1))  /* register +/- numeric constant? */
+      op = (op == OP_ADD) ? OP_ADDK : OP_SUBK;
     e1->u.s.info = luaK_codeABC(fs, op, 0, o1, o2);
     e1->k = VRELOCABLE;
   }
@@ -751,6 +754,13 @@ static void codecomp (FuncState *fs, OpCode op, int cond, expdesc *e1,
     temp = o1; o1 = o2; o2 = temp;  /* o1 <==> o2 */
     cond = 1;
   }
+  else if (op == OP_EQ && ISK(o1) != ISK(o2)) {  /* register == constant? */
+    if (ISK(o1)) {
+      int temp;  /* put the constant second (no `__eq' can be called) */
+      temp = o1; o1 = o2; o2 = temp;
+    }
+    op = OP_EQK;
+  }
   e1->u.s.info = condjump(fs, op, cond, o1, o2);
   e1->k = VJMP;
 }
@@ -70,6 +70,8 @@ LUA_API int lua_sethook (lua_State *L, lua_Hook func, int mask, int count) {
   L->hook = func;
   L->basehookcount = count;
   resethookcount(L);
+  /* a running `luaV_execute' sees the new mask at its next call,
+     metamethod, return or jump (see `vmhookcheck') */
   L->hookmask = cast_byte(mask);
   return 1;
 }
@@ -335,6 +337,7 @@ static Instruction symbexec (const Proto *pt, int lastpc, int reg) {
     int b = 0;
     int c = 0;
     check(op < NUM_OPCODES);
+    op = getBaseOp(op);  /* look through quickened instructions */
     checkreg(pt, a);
     switch (getOpMode(op)) {
       case iABC: {
@@ -412,6 +415,15 @@ static Instruction symbexec (const Proto *pt, int lastpc, int reg) {
         check(b < c);  /* at least two operands */
         break;
       }
+      case OP_EQK: {
+        check(ISK(c));
+        break;
+      }
+      case OP_ADDK:
+      case OP_SUBK: {
+        check(ISK(c) && ttisnumber(&pt->k[INDEXK(c)]));
+        break;
+      }
       case OP_TFORLOOP: {
         check(c >= 1);  /* at least one result (control variable) */
         checkreg(pt, a+2+c);  /* space for results */
@@ -514,7 +526,7 @@ static const char *getobjname (lua_State *L, CallInfo *ci, int stackpos,
       return "local";
     i = symbexec(p, pc, stackpos);  /* try symbolic execution */
     lua_assert(pc != -1);
-    switch (GET_OPCODE(i)) {
+    switch (getBaseOp(GET_OPCODE(i))) {
       case OP_GETGLOBAL: {
         int g = GETARG_Bx(i);  /* global index */
         lua_assert(ttisstring(&p->k[g]));
@@ -14,6 +14,7 @@
 
 #include "lfunc.h"
 #include "lgc.h"
+#include "ljit.h"
 #include "lmem.h"
 #include "lobject.h"
 #include "lstate.h"
@@ -26,6 +27,9 @@ Closure *luaF_newCclosure (lua_State *L, int nelems, Table *e) {
   c->c.isC = 1;
   c->c.env = e;
   c->c.nupvalues = cast_byte(nelems);
+  c->c.fastf = NULL;
+  c->c.iter = 0;
+  c->c.intrinsic = 0;
   return c;
 }
 
@@ -131,6 +135,9 @@ Proto *luaF_newproto (lua_State *L) {
   f->code = NULL;
   f->sizecode = 0;
   f->sizelineinfo = 0;
+  f->icache = NULL;
+  f->sizeicache = 0;
+  f->aot = NULL;
   f->sizeupvalues = 0;
   f->nups = 0;
   f->upvalues = NULL;
@@ -143,17 +150,38 @@ Proto *luaF_newproto (lua_State *L) {
   f->linedefined = 0;
   f->lastlinedefined = 0;
   f->source = NULL;
+#if defined(LUA_USE_JIT)
+  f->jit = NULL;
+  f->jithot = LUAI_JITHOT;
+#endif
   return f;
 }
 
 
+/*
+** allocates the inline caches of `f' (one slot per instruction, used by
+** the table accesses of `luaV_execute'); must be called once its code
+** is complete
+*/
+void luaF_newicache (lua_State *L, Proto *f) {
+  int i;
+  f->icache = luaM_newvector(L, f->sizecode, int);
+  f->sizeicache = f->sizecode;
+  for (i = 0; i < f->sizecode; i++) f->icache[i] = 0;
+}
+
+
 void luaF_freeproto (lua_State *L, Proto *f) {
   luaM_freearray(L, f->code, f->sizecode, Instruction);
   luaM_freearray(L, f->p, f->sizep, Proto *);
   luaM_freearray(L, f->k, f->sizek, TValue);
   luaM_freearray(L, f->lineinfo, f->sizelineinfo, int);
+  luaM_freearray(L, f->icache, f->sizeicache, int);
   luaM_freearray(L, f->locvars, f->sizelocvars, struct LocVar);
   luaM_freearray(L, f->upvalues, f->sizeupvalues, TString *);
+#if defined(LUA_USE_JIT)
+  luaJ_free(L, f);
+#endif
   luaM_free(L, f);
 }
 
@@ -21,6 +21,7 @@
 #include "lstring.h"
 #include "ltable.h"
 #include "ltm.h"
+#include "lvm.h"
 
 // 每次自动GC至少的尺寸
 #define GCSTEPSIZE	1024u
@@ -28,6 +29,9 @@
 #define GCSWEEPCOST	10
 #define GCFINALIZECOST	100
 
+/* a hash part this big and this empty is compacted at its next insertion */
+#define issparse(used,size)	((size) >= 64 && (used) < (size) / 8)
+
 // 除了黑白色之外的位值
 #define maskmarks	cast_byte(~(bitmask(BLACKBIT)|WHITEBITS))
 
@@ -171,9 +175,36 @@ size_t luaC_separateudata (lua_State *L, int all) {
   return deadmem;
 }
 
+/*
+** marks the live entries of hash part `node' with `size' nodes; returns
+** how many there are
+*/
+static int traversenodes (global_State *g, Node *node, int size,
+                          int weakkey, int weakvalue) {
+  int used = 0;
+  int i = size;
+  while (i--) {
+    Node *n = &node[i];
+    lua_assert(ttype(gkey(n)) != LUA_TDEADKEY || ttisnil(gval(n)));
+    // 如果值已经是nil了,直接把这个节点删除了
+    if (ttisnil(gval(n)))
+      removeentry(n);  /* remove empty entries */
+    else {
+      lua_assert(!ttisnil(gkey(n)));
+      // 分别视到底是弱值还是弱键情况mark值和键
+      if (!weakkey) markvalue(g, gkey(n));
+      if (!weakvalue) markvalue(g, gval(n));
+      used++;
+    }
+  }
+  return used;
+}
+
+
 // 遍历一个表, 返回1表示是弱表
 static int traversetable (global_State *g, Table *h) {
   int i;
+  int used;
   int weakkey = 0;
   int weakvalue = 0;
   const TValue *mode;
@@ -208,20 +239,12 @@ static int traversetable (global_State *g, Table *h) {
       markvalue(g, &h->array[i]);
   }
   // 无论是弱值还是弱key都需要做这一步:遍历hash部分,根据是弱值/key来标记key/值
-  i = sizenode(h);
-  while (i--) {
-    Node *n = gnode(h, i);
-    lua_assert(ttype(gkey(n)) != LUA_TDEADKEY || ttisnil(gval(n)));
-    // 如果值已经是nil了,直接把这个节点删除了
-    if (ttisnil(gval(n)))
-      removeentry(n);  /* remove empty entries */
-    else {
-      lua_assert(!ttisnil(gkey(n)));
-      // 分别视到底是弱值还是弱键情况mark值和键
-      if (!weakkey) markvalue(g, gkey(n));
-      if (!weakvalue) markvalue(g, gval(n));
-    }
-  }
+  used = traversenodes(g, h->node, sizenode(h), weakkey, weakvalue);
+  if (h->oldnode != NULL)  /* hash part still being moved? */
+    used += traversenodes(g, h->oldnode, twoto(h->oldlsizenode),
+                          weakkey, weakvalue);
+  if (issparse(used, sizenode(h)))
+    h->sparse = 1;  /* compact it at its next insertion (see `newkey') */
   return weakkey || weakvalue;
 }
 
@@ -327,7 +350,12 @@ static l_mem propagatemark (global_State *g) {
       if (traversetable(g, h))  /* table is weak? */
         black2gray(o);  /* keep it gray */
       return sizeof(Table) + sizeof(TValue) * h->sizearray +
-                             sizeof(Node) * sizenode(h);
+#if defined(LUA_PACKARRAY)
+                             sizeof(PackedNum) * h->sizenarray +
+#endif
+                             sizeof(Node) * sizenode(h) +
+                             ((h->oldnode != NULL) ?
+                                sizeof(Node) * twoto(h->oldlsizenode) : 0);
     }
     case LUA_TFUNCTION: {
       Closure *cl = gco2cl(o);
@@ -355,6 +383,7 @@ static l_mem propagatemark (global_State *g) {
                              sizeof(Proto *) * p->sizep +
                              sizeof(TValue) * p->sizek + 
                              sizeof(int) * p->sizelineinfo +
+                             sizeof(int) * p->sizeicache +
                              sizeof(LocVar) * p->sizelocvars +
                              sizeof(TString *) * p->sizeupvalues;
     }
@@ -391,6 +420,25 @@ static int iscleared (const TValue *o, int iskey) {
 }
 
 
+/* clears the collected entries of hash part `node' with `size' nodes */
+static void clearnodes (Node *node, int size) {
+  int i = size;
+  while (i--) {
+    // 遍历hash元素,这一步无论是弱值还是弱key都要处理
+    Node *n = &node[i];
+    if (!ttisnil(gval(n)) &&  /* non-empty entry? */
+        (iscleared(key2tval(n), 1) || iscleared(gval(n), 0))) {
+      // 如果不是空值， 同时key或者值已经被清理掉了
+
+      // 清理值
+      setnilvalue(gval(n));  /* remove value ... */
+      // 将该节点从hash中删除
+      removeentry(n);  /* remove entry from table */
+    }
+  }
+}
+
+
 /*
 ** clear collected entries from weaktables
 */
@@ -410,20 +458,9 @@ static void cleartable (GCObject *l) {
           setnilvalue(o);  /* remove value */
       }
     }
-    i = sizenode(h);
-    while (i--) {
-      // 遍历hash元素,这一步无论是弱值还是弱key都要处理
-      Node *n = gnode(h, i);
-      if (!ttisnil(gval(n)) &&  /* non-empty entry? */
-          (iscleared(key2tval(n), 1) || iscleared(gval(n), 0))) {
-    	// 如果不是空值， 同时key或者值已经被清理掉了
-
-    	// 清理值
-        setnilvalue(gval(n));  /* remove value ... */
-        // 将该节点从hash中删除
-        removeentry(n);  /* remove entry from table */
-      }
-    }
+    clearnodes(h->node, sizenode(h));
+    if (h->oldnode != NULL)  /* hash part still being moved? */
+      clearnodes(h->oldnode, twoto(h->oldlsizenode));
     l = h->gclist;
   }
 }
@@ -618,6 +655,7 @@ static void atomic (lua_State *L) {
   udsize += propagateall(g);  /* remark, to propagate `preserveness' */
   // 一个原子的过程去mark弱表
   cleartable(g->weak);  /* remove collected objects from weak tables */
+  luaV_newversion(g);  /* cached methods may refer to dead objects */
   /* flip current white */
   g->currentwhite = cast_byte(otherwhite(g));
   g->sweepstrgc = 0;
@@ -770,7 +808,7 @@ void luaC_barrierf (lua_State *L, GCObject *o, GCObject *v) {
   // gcstate不等于GCSfinalize和GCSpause
   lua_assert(g->gcstate != GCSfinalize && g->gcstate != GCSpause);
   // o的类型不是TABLE
-  lua_assert(ttype(&o->gch) != LUA_TTABLE);
+  lua_assert(o->gch.tt != LUA_TTABLE);
   /* must keep invariant? */
   if (g->gcstate == GCSpropagate)
 	// 如果在mark阶段，就把要关联的值也mark起来
@@ -0,0 +1,941 @@
+/*
+** $Id: ljit.c $
+** Baseline compiler from Lua bytecode to x86-64 machine code
+** See Copyright Notice in lua.h
+*/
+
+
+#include <stddef.h>
+#include <string.h>
+
+#define ljit_c
+#define LUA_CORE
+
+#include "lua.h"
+
+#if defined(LUA_USE_JIT)
+
+#include <sys/mman.h>
+
+#include "ldebug.h"
+#include "ldo.h"
+#include "lfunc.h"
+#include "lgc.h"
+#include "ljit.h"
+#include "lmem.h"
+#include "lobject.h"
+#include "lopcodes.h"
+#include "lstate.h"
+#include "ltable.h"
+#include "ltm.h"
+#include "lvm.h"
+
+
+/*
+** Each instruction of a hot function becomes one template of machine
+** code, so there is no dispatch and no operand decoding left: register
+** and constant addresses are immediates. Moves, loads, jumps, tests,
+** numeric `for' loops and number/number arithmetic and comparisons run
+** inline; everything else calls its out-of-line form in lvm.c
+** (`luaV_opgettable' & co.) and reloads `base' afterwards.
+** Calls, returns, closures and varargs are not compiled: their code
+** returns to `luaV_execute', which runs them and comes back through
+** `luaJ_enter' at the next backward jump; functions with such
+** instructions inside loops are therefore not compiled. Calls of C
+** functions that the interpreter made without a CallInfo are the
+** exception (see `emitcall').
+**
+** Machine code runs with `base' in rbx, the lua_State in r12 and the
+** constants of the function in r13. It is entered at the code of any
+** instruction and returns the `pc' where the interpreter must go on.
+** It leaves as soon as a line or count hook appears.
+*/
+
+
+typedef const Instruction *(*JitFunc) (lua_State *L, const void *entry);
+
+typedef int (*Helper) (lua_State *L, Instruction i);
+
+
+typedef struct JitCode {
+  size_t size;  /* size of the whole mapping */
+  unsigned char *mcode;  /* machine code; starts with the entry sequence */
+  int entry[1];  /* offset in `mcode' of each instruction */
+} JitCode;
+
+
+/* functions larger than this are left to the interpreter */
+#define MAXJITCODE	8192
+
+/* upper bound of the size of one template */
+#define MAXTEMPLATE	512
+
+
+typedef struct Fixup {
+  int pos;  /* position of a rel32 field */
+  int target;  /* instruction it jumps to */
+} Fixup;
+
+
+typedef struct JitState {
+  Proto *p;
+  int pc;  /* instruction being compiled */
+  unsigned char *buf;
+  int n;  /* bytes in `buf' */
+  int *label;  /* offset of the code of each instruction */
+  lu_byte *flags;  /* JF_* for each instruction */
+  Fixup *fix;
+  int nfix;
+  int epilogue;  /* offset of the code that returns to the interpreter */
+} JitState;
+
+
+#define JF_CHECK	1  /* starts with a hook check */
+#define JF_DATA		2  /* not an instruction */
+
+
+/* x86-64 registers */
+enum { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+       R8, R9, R10, R11, R12, R13, R14, R15 };
+
+#define RBASE	RBX
+#define RSTATE	R12
+#define RCONST	R13
+
+/* condition codes */
+#define CC_O	0x0
+#define CC_B	0x2
+#define CC_AE	0x3
+#define CC_E	0x4
+#define CC_NE	0x5
+#define CC_BE	0x6
+#define CC_A	0x7
+#define CC_L	0xC
+#define CC_GE	0xD
+#define CC_LE	0xE
+#define CC_G	0xF
+#define CC_ALWAYS	(-1)
+
+/* x86-64 opcodes used with a memory operand */
+#define X_ADD	0x03
+#define X_SUB	0x2B
+#define X_CMP	0x3B
+#define X_CMPRM	0x39
+#define X_STORE	0x89
+#define X_LOAD	0x8B
+#define X_SSELOAD	0x10
+#define X_SSESTORE	0x11
+#define X_ADDSD	0x58
+#define X_MULSD	0x59
+#define X_SUBSD	0x5C
+#define X_DIVSD	0x5E
+#define X_UCOMISD	0x2E
+#define X_CVTSI2SD	0x2A
+
+#define SLOT(r)		(cast_int(sizeof(TValue)) * (r))
+#define TT		cast_int(offsetof(TValue, tt))
+#define LOFF(f)		cast_int(offsetof(lua_State, f))
+
+#define HOOKMASK	(LUA_MASKLINE | LUA_MASKCOUNT)
+
+
+
+
+
+/*
+** {======================================================
+** Code emission
+** =======================================================
+*/
+
+static void eb (JitState *J, int b) {
+  J->buf[J->n++] = cast(unsigned char, b);
+}
+
+
+static void e32 (JitState *J, int v) {
+  memcpy(J->buf + J->n, &v, 4);
+  J->n += 4;
+}
+
+
+static void e64 (JitState *J, size_t v) {
+  memcpy(J->buf + J->n, &v, 8);
+  J->n += 8;
+}
+
+
+static void rex (JitState *J, int w, int r, int b) {
+  int x = 0x40 | (w << 3) | ((r & 8) >> 1) | ((b & 8) >> 3);
+  if (x != 0x40) eb(J, x);
+}
+
+
+/* ModRM (and SIB) for the operand [b + disp32] */
+static void mem (JitState *J, int r, int b, int disp) {
+  eb(J, 0x80 | ((r & 7) << 3) | (b & 7));
+  if ((b & 7) == RSP) eb(J, 0x24);
+  e32(J, disp);
+}
+
+
+/* instruction `op' between register `r' and [b + disp] */
+static void oprm (JitState *J, int w, int op, int r, int b, int disp) {
+  rex(J, w, r, b);
+  eb(J, op);
+  mem(J, r, b, disp);
+}
+
+
+/* scalar double instruction `op' between xmm`x' and [b + disp] */
+static void sse (JitState *J, int pfx, int op, int x, int b, int disp) {
+  eb(J, pfx);
+  rex(J, 0, x, b);
+  eb(J, 0x0F);
+  eb(J, op);
+  mem(J, x, b, disp);
+}
+
+
+static void movimm (JitState *J, int r, size_t v) {
+  rex(J, 1, 0, r);
+  eb(J, 0xB8 + (r & 7));
+  e64(J, v);
+}
+
+
+/* dword [b + disp] := imm (sign-extended to a qword if `w') */
+static void storeimm (JitState *J, int w, int b, int disp, int imm) {
+  oprm(J, w, 0xC7, 0, b, disp);
+  e32(J, imm);
+}
+
+
+static void cmpimm (JitState *J, int b, int disp, int imm) {
+  oprm(J, 0, 0x81, 7, b, disp);
+  e32(J, imm);
+}
+
+
+static void setcc (JitState *J, int cc) {  /* eax := condition `cc' */
+  eb(J, 0x0F); eb(J, 0x90 | cc); eb(J, 0xC0);  /* setcc al */
+  eb(J, 0x0F); eb(J, 0xB6); eb(J, 0xC0);  /* movzx eax, al */
+}
+
+
+/* jump within a template; returns the position to patch with `here' */
+static int jump (JitState *J, int cc) {
+  if (cc == CC_ALWAYS)
+    eb(J, 0xE9);
+  else {
+    eb(J, 0x0F);
+    eb(J, 0x80 | cc);
+  }
+  e32(J, 0);
+  return J->n - 4;
+}
+
+
+static void patch (JitState *J, int pos, int dest) {
+  int rel = dest - (pos + 4);
+  memcpy(J->buf + pos, &rel, 4);
+}
+
+
+static void here (JitState *J, int pos) {
+  if (pos >= 0) patch(J, pos, J->n);
+}
+
+
+/* jump to the code of instruction `target' */
+static void jumpto (JitState *J, int cc, int target) {
+  int pos = jump(J, cc);
+  if (target <= J->pc)
+    patch(J, pos, J->label[target]);
+  else {
+    J->fix[J->nfix].pos = pos;
+    J->fix[J->nfix].target = target;
+    J->nfix++;
+  }
+}
+
+
+/* returns to the interpreter, which goes on at instruction `pc' */
+static void exitto (JitState *J, int pc) {
+  movimm(J, RAX, cast(size_t, &J->p->code[pc]));
+  patch(J, jump(J, CC_ALWAYS), J->epilogue);
+}
+
+
+static void hookcheck (JitState *J, int pc) {
+  int skip;
+  oprm(J, 0, 0xF6, 0, RSTATE, LOFF(hookmask));  /* test byte [...], imm8 */
+  eb(J, HOOKMASK);
+  skip = jump(J, CC_E);
+  exitto(J, pc);
+  here(J, skip);
+}
+
+
+/* calls helper `f' for instruction `i' and leaves its result in eax */
+static void callhelper (JitState *J, Helper f, Instruction i) {
+  movimm(J, RAX, cast(size_t, &J->p->code[J->pc + 1]));
+  oprm(J, 1, X_STORE, RAX, RSTATE, LOFF(savedpc));
+  rex(J, 1, RSTATE, RDI); eb(J, 0x89); eb(J, 0xC0 | ((RSTATE & 7) << 3) | RDI);
+  eb(J, 0xBE); e32(J, cast_int(i));  /* mov esi, i */
+  movimm(J, RAX, cast(size_t, f));
+  eb(J, 0xFF); eb(J, 0xD0);  /* call rax */
+  oprm(J, 1, X_LOAD, RBASE, RSTATE, LOFF(base));  /* stack may have moved */
+}
+
+
+/* helper for an instruction that falls through to the next one */
+static void callhelperseq (JitState *J, Helper f, Instruction i, int next) {
+  callhelper(J, f, i);
+  hookcheck(J, next);
+}
+
+
+static void copyslot (JitState *J, int db, int dd, int sb, int sd) {
+  oprm(J, 1, X_LOAD, RAX, sb, sd);
+  oprm(J, 1, X_LOAD, RCX, sb, sd + 8);
+  oprm(J, 1, X_STORE, RAX, db, dd);
+  oprm(J, 1, X_STORE, RCX, db, dd + 8);
+}
+
+
+/* base register and displacement of RK operand `x' */
+static void rk (int x, int *b, int *d) {
+  if (ISK(x)) { *b = RCONST; *d = SLOT(INDEXK(x)); }
+  else { *b = RBASE; *d = SLOT(x); }
+}
+
+
+/* branch of a test: eax holds the outcome; jump if it equals `a' */
+static void condjump (JitState *J, int a) {
+  int pc = J->pc;
+  eb(J, 0x85); eb(J, 0xC0);  /* test eax, eax */
+  jumpto(J, a ? CC_E : CC_NE, pc + 2);
+  jumpto(J, CC_ALWAYS, pc + 2 + GETARG_sBx(J->p->code[pc + 1]));
+}
+
+
+/* xmm`x' := number at [b + d]; jumps to `*slow' if it is not a number */
+static void tonum (JitState *J, int x, int b, int d, int *slow) {
+  int isflt, done;
+  cmpimm(J, b, d + TT, LUA_TNUMBER);
+  isflt = jump(J, CC_E);
+  cmpimm(J, b, d + TT, LUA_TNUMINT);
+  *slow = jump(J, CC_NE);
+  sse(J, 0xF2, X_CVTSI2SD, x, b, d);
+  done = jump(J, CC_ALWAYS);
+  here(J, isflt);
+  sse(J, 0xF2, X_SSELOAD, x, b, d);
+  here(J, done);
+}
+
+
+/*
+** ADD, SUB and MUL of two ints stay ints unless the result overflows
+** (or is a zero, which may have to be -0); other pairs of numbers are
+** computed as lua_Numbers, like `arith_op' does
+*/
+static void emitarith (JitState *J, Instruction i, int op, int bb, int bd,
+                       int cb, int cd) {
+  int a = SLOT(GETARG_A(i));
+  int toflt1 = -1, toflt2 = -1, ovf = -1, zero = -1, done1 = -1;
+  int slow1, slow2, done2;
+  if (op != X_DIVSD) {  /* integer path */
+    cmpimm(J, bb, bd + TT, LUA_TNUMINT);
+    toflt1 = jump(J, CC_NE);
+    cmpimm(J, cb, cd + TT, LUA_TNUMINT);
+    toflt2 = jump(J, CC_NE);
+    oprm(J, 0, X_LOAD, RAX, bb, bd);
+    if (op == X_MULSD) {
+      rex(J, 0, RAX, cb);
+      eb(J, 0x0F); eb(J, 0xAF);  /* imul eax, [...] */
+      mem(J, RAX, cb, cd);
+    }
+    else
+      oprm(J, 0, op == X_ADDSD ? X_ADD : X_SUB, RAX, cb, cd);
+    ovf = jump(J, CC_O);
+    if (op == X_MULSD) {
+      eb(J, 0x85); eb(J, 0xC0);  /* test eax, eax */
+      zero = jump(J, CC_E);
+    }
+    eb(J, 0x48); eb(J, 0x63); eb(J, 0xC0);  /* movsxd rax, eax */
+    oprm(J, 1, X_STORE, RAX, RBASE, a);
+    storeimm(J, 0, RBASE, a + TT, LUA_TNUMINT);
+    done1 = jump(J, CC_ALWAYS);
+    here(J, toflt1); here(J, toflt2); here(J, ovf);
+  }
+  tonum(J, 0, bb, bd, &slow1);
+  tonum(J, 1, cb, cd, &slow2);
+  eb(J, 0xF2); eb(J, 0x0F); eb(J, op); eb(J, 0xC1);  /* op xmm0, xmm1 */
+  sse(J, 0xF2, X_SSESTORE, 0, RBASE, a);
+  storeimm(J, 0, RBASE, a + TT, LUA_TNUMBER);
+  done2 = jump(J, CC_ALWAYS);
+  here(J, slow1); here(J, slow2); here(J, zero);
+  callhelperseq(J, luaV_oparith, i, J->pc + 1);
+  here(J, done1); here(J, done2);
+}
+
+
+/* LT and LE, with numbers handled inline */
+static void emitorder (JitState *J, Instruction i, int lt) {
+  int bb, bd, cb, cd;
+  int toflt1, toflt2, slow1, slow2, done1, done2;
+  rk(GETARG_B(i), &bb, &bd);
+  rk(GETARG_C(i), &cb, &cd);
+  cmpimm(J, bb, bd + TT, LUA_TNUMINT);
+  toflt1 = jump(J, CC_NE);
+  cmpimm(J, cb, cd + TT, LUA_TNUMINT);
+  toflt2 = jump(J, CC_NE);
+  oprm(J, 0, X_LOAD, RAX, bb, bd);
+  oprm(J, 0, X_CMP, RAX, cb, cd);
+  setcc(J, lt ? CC_L : CC_LE);
+  done1 = jump(J, CC_ALWAYS);
+  here(J, toflt1); here(J, toflt2);
+  tonum(J, 0, bb, bd, &slow1);
+  tonum(J, 1, cb, cd, &slow2);
+  eb(J, 0x66); eb(J, 0x0F); eb(J, X_UCOMISD); eb(J, 0xC8);  /* c with b */
+  setcc(J, lt ? CC_A : CC_AE);  /* false when unordered */
+  done2 = jump(J, CC_ALWAYS);
+  here(J, slow1); here(J, slow2);
+  callhelper(J, lt ? luaV_oplt : luaV_ople, i);
+  here(J, done1); here(J, done2);
+  condjump(J, GETARG_A(i));
+}
+
+
+/* EQK against nil, booleans, strings and ints inline */
+static void emiteqk (JitState *J, Instruction i) {
+  int bd = SLOT(GETARG_B(i));
+  const TValue *kc = J->p->k + INDEXK(GETARG_C(i));
+  if (ttisnil(kc)) {
+    cmpimm(J, RBASE, bd + TT, LUA_TNIL);
+    setcc(J, CC_E);
+  }
+  else if (ttisboolean(kc) || ttisstring(kc)) {
+    int skip;
+    eb(J, 0x31); eb(J, 0xC0);  /* xor eax, eax */
+    cmpimm(J, RBASE, bd + TT, ttype(kc));
+    skip = jump(J, CC_NE);
+    if (ttisboolean(kc))
+      cmpimm(J, RBASE, bd, bvalue(kc));
+    else {
+      movimm(J, RCX, cast(size_t, rawtsvalue(kc)));
+      oprm(J, 1, X_CMPRM, RCX, RBASE, bd);
+    }
+    eb(J, 0x0F); eb(J, 0x94); eb(J, 0xC0);  /* sete al */
+    here(J, skip);
+  }
+  else if (ttisint(kc)) {
+    int slow, done;
+    cmpimm(J, RBASE, bd + TT, LUA_TNUMINT);
+    slow = jump(J, CC_NE);
+    cmpimm(J, RBASE, bd, ivalue(kc));
+    setcc(J, CC_E);
+    done = jump(J, CC_ALWAYS);
+    here(J, slow);
+    callhelper(J, luaV_opeqk, i);
+    here(J, done);
+  }
+  else
+    callhelper(J, luaV_opeqk, i);
+  condjump(J, GETARG_A(i));
+}
+
+
+static void emitforloop (JitState *J, Instruction i) {
+  int a = SLOT(GETARG_A(i));
+  int target = J->pc + 1 + GETARG_sBx(i);
+  int toflt, done1, done2, neg, cont, done3, fneg, done4, done5, fcont;
+  cmpimm(J, RBASE, a + TT, LUA_TNUMINT);
+  toflt = jump(J, CC_NE);
+  /* integer loop */
+  oprm(J, 0, X_LOAD, RAX, RBASE, a);
+  oprm(J, 0, X_LOAD, RCX, RBASE, a + SLOT(2));
+  eb(J, 0x01); eb(J, 0xC8);  /* add eax, ecx */
+  done1 = jump(J, CC_O);
+  eb(J, 0x85); eb(J, 0xC9);  /* test ecx, ecx */
+  neg = jump(J, CC_LE);
+  oprm(J, 0, X_CMP, RAX, RBASE, a + SLOT(1));
+  done2 = jump(J, CC_G);
+  cont = jump(J, CC_ALWAYS);
+  here(J, neg);
+  oprm(J, 0, X_CMP, RAX, RBASE, a + SLOT(1));
+  done3 = jump(J, CC_L);
+  here(J, cont);
+  eb(J, 0x48); eb(J, 0x63); eb(J, 0xC0);  /* movsxd rax, eax */
+  oprm(J, 1, X_STORE, RAX, RBASE, a);
+  oprm(J, 1, X_STORE, RAX, RBASE, a + SLOT(3));
+  storeimm(J, 0, RBASE, a + SLOT(3) + TT, LUA_TNUMINT);
+  jumpto(J, CC_ALWAYS, target);
+  /* float loop */
+  here(J, toflt);
+  sse(J, 0xF2, X_SSELOAD, 0, RBASE, a);
+  sse(J, 0xF2, X_ADDSD, 0, RBASE, a + SLOT(2));
+  sse(J, 0xF2, X_SSELOAD, 1, RBASE, a + SLOT(2));
+  eb(J, 0x66); eb(J, 0x0F); eb(J, 0x57); eb(J, 0xD2);  /* xorpd xmm2, xmm2 */
+  eb(J, 0x66); eb(J, 0x0F); eb(J, 0x2E); eb(J, 0xCA);  /* ucomisd xmm1, xmm2 */
+  fneg = jump(J, CC_BE);  /* not 0 < step */
+  sse(J, 0xF2, X_SSELOAD, 1, RBASE, a + SLOT(1));
+  eb(J, 0x66); eb(J, 0x0F); eb(J, 0x2E); eb(J, 0xC8);  /* ucomisd xmm1, xmm0 */
+  done4 = jump(J, CC_B);  /* not idx <= limit */
+  fcont = jump(J, CC_ALWAYS);
+  here(J, fneg);
+  sse(J, 0x66, X_UCOMISD, 0, RBASE, a + SLOT(1));
+  done5 = jump(J, CC_B);  /* not limit <= idx */
+  here(J, fcont);
+  sse(J, 0xF2, X_SSESTORE, 0, RBASE, a);
+  sse(J, 0xF2, X_SSESTORE, 0, RBASE, a + SLOT(3));
+  storeimm(J, 0, RBASE, a + SLOT(3) + TT, LUA_TNUMBER);
+  jumpto(J, CC_ALWAYS, target);
+  here(J, done1); here(J, done2); here(J, done3); here(J, done4);
+  here(J, done5);
+}
+
+
+static void emittest (JitState *J, Instruction i) {
+  int a = SLOT(GETARG_A(i));
+  int isnil, notbool, istrue;
+  oprm(J, 0, X_LOAD, RCX, RBASE, a + TT);
+  eb(J, 0x31); eb(J, 0xC0);  /* xor eax, eax */
+  eb(J, 0x85); eb(J, 0xC9);  /* test ecx, ecx */
+  isnil = jump(J, CC_E);
+  eb(J, 0x83); eb(J, 0xF9); eb(J, LUA_TBOOLEAN);  /* cmp ecx, imm8 */
+  notbool = jump(J, CC_NE);
+  cmpimm(J, RBASE, a, 0);
+  istrue = jump(J, CC_NE);
+  here(J, isnil);
+  eb(J, 0xB8); e32(J, 1);  /* mov eax, 1 */
+  here(J, notbool); here(J, istrue);
+  /* eax is `l_isfalse(ra)'; jump if it differs from C */
+  condjump(J, !GETARG_C(i));
+}
+
+
+static void emitgetupval (JitState *J, Instruction i) {
+  oprm(J, 1, X_LOAD, RAX, RSTATE, LOFF(ci));
+  oprm(J, 1, X_LOAD, RAX, RAX, cast_int(offsetof(CallInfo, func)));
+  oprm(J, 1, X_LOAD, RAX, RAX, 0);  /* the closure */
+  oprm(J, 1, X_LOAD, RAX, RAX, cast_int(offsetof(LClosure, upvals)) +
+                               cast_int(sizeof(UpVal *)) * GETARG_B(i));
+  oprm(J, 1, X_LOAD, RDX, RAX, cast_int(offsetof(UpVal, v)));
+  copyslot(J, RBASE, SLOT(GETARG_A(i)), RDX, 0);
+}
+
+
+/* t[n] for an int `n' in the array part of `t' inline */
+static void emitgettable (JitState *J, Instruction i) {
+  int tb = SLOT(GETARG_B(i));
+  int cb, cd;
+  int slow1, slow2, slow3, slow4, done;
+  rk(GETARG_C(i), &cb, &cd);
+  cmpimm(J, RBASE, tb + TT, LUA_TTABLE);
+  slow1 = jump(J, CC_NE);
+  cmpimm(J, cb, cd + TT, LUA_TNUMINT);
+  slow2 = jump(J, CC_NE);
+  oprm(J, 1, X_LOAD, RAX, RBASE, tb);
+  oprm(J, 0, X_LOAD, RCX, cb, cd);
+  eb(J, 0xFF); eb(J, 0xC9);  /* dec ecx */
+  oprm(J, 0, X_CMP, RCX, RAX, cast_int(offsetof(Table, sizearray)));
+  slow3 = jump(J, CC_AE);  /* also catches n <= 0 */
+  oprm(J, 1, X_LOAD, RDX, RAX, cast_int(offsetof(Table, array)));
+  eb(J, 0x48); eb(J, 0xC1); eb(J, 0xE1); eb(J, 4);  /* shl rcx, 4 */
+  eb(J, 0x48); eb(J, 0x01); eb(J, 0xCA);  /* add rdx, rcx */
+  cmpimm(J, RDX, TT, LUA_TNIL);
+  slow4 = jump(J, CC_E);  /* may need `__index' */
+  copyslot(J, RBASE, SLOT(GETARG_A(i)), RDX, 0);
+  done = jump(J, CC_ALWAYS);
+  here(J, slow1); here(J, slow2); here(J, slow3); here(J, slow4);
+  callhelperseq(J, luaV_opgettable, i, J->pc + 1);
+  here(J, done);
+}
+
+
+/*
+** whether the OP_CALL at `pc' is compiled: the interpreter has made it
+** without a CallInfo (see `callfast' in lvm.c), and it has fixed numbers
+** of arguments and results
+*/
+static int fastcallat (Proto *p, int pc) {
+  Instruction i = p->code[pc];
+  return GETARG_B(i) != 0 && GETARG_C(i) != 0 && p->icache[pc] != 0;
+}
+
+
+/*
+** a compiled OP_CALL: the builtin the interpreter computed there (see
+** `intrinsic' in lvm.c) is computed inline, once the mark on the called
+** CClosure and the arguments are checked; string.byte, fast C functions
+** and whatever fails those checks go to `luaV_opcall', and what that
+** declines goes back to the interpreter
+*/
+static void emitcall (JitState *J, Instruction i) {
+  int a = SLOT(GETARG_A(i));
+  int kind = J->p->icache[J->pc];
+  int nargs = GETARG_B(i) - 1;
+  int slow[6], ns = 0;
+  int j, ok, done = -1;
+  if (kind > 0 && kind != LUA_INTRBYTE &&
+      nargs == (kind < LUA_INTRFMOD ? 1 : 2)) {
+    oprm(J, 0, 0xF6, 0, RSTATE, LOFF(hookmask));  /* test byte [...], imm8 */
+    eb(J, LUA_MASKCALL | LUA_MASKRET);
+    slow[ns++] = jump(J, CC_NE);
+    cmpimm(J, RBASE, a + TT, LUA_TFUNCTION);
+    slow[ns++] = jump(J, CC_NE);
+    oprm(J, 1, X_LOAD, RAX, RBASE, a);  /* the closure */
+    oprm(J, 0, 0x80, 7, RAX, cast_int(offsetof(CClosure, isC)));
+    eb(J, 0);  /* cmp byte [...], 0 */
+    slow[ns++] = jump(J, CC_E);
+    oprm(J, 0, 0x80, 7, RAX, cast_int(offsetof(CClosure, intrinsic)));
+    eb(J, kind);
+    slow[ns++] = jump(J, CC_NE);
+    if (kind == LUA_INTRLEN) {
+      cmpimm(J, RBASE, a + SLOT(1) + TT, LUA_TSTRING);
+      slow[ns++] = jump(J, CC_NE);
+      oprm(J, 1, X_LOAD, RAX, RBASE, a + SLOT(1));
+      oprm(J, 1, X_LOAD, RAX, RAX, cast_int(offsetof(TString, tsv.len)));
+      eb(J, 0x48); eb(J, 0x3D); e32(J, MAX_INT);  /* cmp rax, MAX_INT */
+      slow[ns++] = jump(J, CC_A);
+      oprm(J, 1, X_STORE, RAX, RBASE, a);
+      storeimm(J, 0, RBASE, a + TT, LUA_TNUMINT);
+    }
+    else {
+      tonum(J, 0, RBASE, a + SLOT(1), &slow[ns++]);
+      if (nargs == 2) tonum(J, 1, RBASE, a + SLOT(2), &slow[ns++]);
+      switch (kind) {
+        case LUA_INTRABS: break;  /* clears the sign below */
+        case LUA_INTRSQRT: {
+          eb(J, 0xF2); eb(J, 0x0F); eb(J, 0x51); eb(J, 0xC0);  /* sqrtsd */
+          break;
+        }
+        case LUA_INTRMIN: case LUA_INTRMAX: {  /* `y' unless it is not */
+          eb(J, 0xF2); eb(J, 0x0F);  /* smaller/greater, like lmin/lmax */
+          eb(J, kind == LUA_INTRMIN ? 0x5D : 0x5F); eb(J, 0xC8);
+          eb(J, 0xF2); eb(J, 0x0F); eb(J, X_SSELOAD); eb(J, 0xC1);
+          break;
+        }
+        default: {  /* the C library function, as `intrinsic' calls it */
+          static double (*const f1[])(double) = {
+            NULL, NULL, ceil, floor, NULL, sin, cos, exp, log
+          };
+          movimm(J, RAX, kind == LUA_INTRFMOD ? cast(size_t, fmod)
+                                              : cast(size_t, f1[kind]));
+          eb(J, 0xFF); eb(J, 0xD0);  /* call rax */
+          break;
+        }
+      }
+      sse(J, 0xF2, X_SSESTORE, 0, RBASE, a);
+      storeimm(J, 0, RBASE, a + TT, LUA_TNUMBER);
+      if (kind == LUA_INTRABS) {
+        rex(J, 1, 0, RBASE); eb(J, 0x0F); eb(J, 0xBA);  /* btr [...], 63 */
+        mem(J, 6, RBASE, a); eb(J, 63);
+      }
+    }
+    for (j = 1; j < GETARG_C(i) - 1; j++)
+      storeimm(J, 0, RBASE, a + SLOT(j) + TT, LUA_TNIL);
+    done = jump(J, CC_ALWAYS);
+  }
+  for (j = 0; j < ns; j++) here(J, slow[j]);
+  callhelper(J, luaV_opcall, i);
+  eb(J, 0x85); eb(J, 0xC0);  /* test eax, eax */
+  ok = jump(J, CC_NE);
+  exitto(J, J->pc);
+  here(J, ok);
+  here(J, done);
+}
+
+
+static void emitinstruction (JitState *J, Instruction i) {
+  int pc = J->pc;
+  int a = GETARG_A(i);
+  switch (getBaseOp(GET_OPCODE(i))) {
+    case OP_MOVE: {
+      copyslot(J, RBASE, SLOT(a), RBASE, SLOT(GETARG_B(i)));
+      break;
+    }
+    case OP_LOADK: {
+      copyslot(J, RBASE, SLOT(a), RCONST, SLOT(GETARG_Bx(i)));
+      break;
+    }
+    case OP_LOADBOOL: {
+      storeimm(J, 1, RBASE, SLOT(a), GETARG_B(i));
+      storeimm(J, 0, RBASE, SLOT(a) + TT, LUA_TBOOLEAN);
+      if (GETARG_C(i)) jumpto(J, CC_ALWAYS, pc + 2);
+      break;
+    }
+    case OP_LOADNIL: {
+      int b = GETARG_B(i);
+      if (b - a < 16) {
+        for (; a <= b; a++) storeimm(J, 0, RBASE, SLOT(a) + TT, LUA_TNIL);
+        break;
+      }
+      exitto(J, pc);
+      break;
+    }
+    case OP_GETUPVAL: emitgetupval(J, i); break;
+    case OP_GETGLOBAL: callhelperseq(J, luaV_opgetglobal, i, pc + 1); break;
+    case OP_GETTABLE: emitgettable(J, i); break;
+    case OP_SETGLOBAL: callhelperseq(J, luaV_opsetglobal, i, pc + 1); break;
+    case OP_SETUPVAL: callhelperseq(J, luaV_opsetupval, i, pc + 1); break;
+    case OP_SETTABLE: callhelperseq(J, luaV_opsettable, i, pc + 1); break;
+    case OP_NEWTABLE: callhelperseq(J, luaV_opnewtable, i, pc + 1); break;
+    case OP_SELF: callhelperseq(J, luaV_opself, i, pc + 1); break;
+    case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV: {
+      static const lu_byte ops[] = {X_ADDSD, X_SUBSD, X_MULSD, X_DIVSD};
+      int bb, bd, cb, cd;
+      rk(GETARG_B(i), &bb, &bd);
+      rk(GETARG_C(i), &cb, &cd);
+      emitarith(J, i, ops[getBaseOp(GET_OPCODE(i)) - OP_ADD], bb, bd, cb, cd);
+      break;
+    }
+    case OP_ADDK: case OP_SUBK: {
+      int cb, cd;
+      rk(GETARG_C(i), &cb, &cd);
+      emitarith(J, i, getBaseOp(GET_OPCODE(i)) == OP_ADDK ? X_ADDSD : X_SUBSD,
+                RBASE, SLOT(GETARG_B(i)), cb, cd);
+      break;
+    }
+    case OP_MOD: case OP_POW: case OP_UNM: {
+      callhelperseq(J, luaV_oparith, i, pc + 1);
+      break;
+    }
+    case OP_NOT: callhelperseq(J, luaV_opnot, i, pc + 1); break;
+    case OP_LEN: callhelperseq(J, luaV_oplen, i, pc + 1); break;
+    case OP_CONCAT: callhelperseq(J, luaV_opconcat, i, pc + 1); break;
+    case OP_JMP: {
+      jumpto(J, CC_ALWAYS, pc + 1 + GETARG_sBx(i));
+      break;
+    }
+    case OP_EQ: {
+      callhelper(J, luaV_opeq, i);
+      condjump(J, a);
+      break;
+    }
+    case OP_LT: emitorder(J, i, 1); break;
+    case OP_LE: emitorder(J, i, 0); break;
+    case OP_EQK: emiteqk(J, i); break;
+    case OP_TEST: emittest(J, i); break;
+    case OP_TESTSET: {
+      callhelper(J, luaV_optestset, i);
+      condjump(J, 1);
+      break;
+    }
+    case OP_FORLOOP: emitforloop(J, i); break;
+    case OP_FORPREP: {
+      callhelper(J, luaV_opforprep, i);
+      jumpto(J, CC_ALWAYS, pc + 1 + GETARG_sBx(i));
+      break;
+    }
+    case OP_TFORLOOP: {
+      callhelper(J, luaV_optforloop, i);
+      condjump(J, 1);
+      break;
+    }
+    case OP_SETLIST: {
+      callhelperseq(J, luaV_opsetlist, i, GETARG_C(i) == 0 ? pc + 2 : pc + 1);
+      if (GETARG_C(i) == 0) jumpto(J, CC_ALWAYS, pc + 2);
+      break;
+    }
+    case OP_CLOSE: callhelperseq(J, luaV_opclose, i, pc + 1); break;
+    case OP_CALL: {
+      if (fastcallat(J->p, pc)) emitcall(J, i);
+      else exitto(J, pc);
+      break;
+    }
+    default: {  /* other CALLs, TAILCALL, RETURN, CLOSURE and VARARG */
+      exitto(J, pc);
+      break;
+    }
+  }
+}
+
+
+/*
+** marks data words (not instructions) and the instructions that must
+** check for hooks on entry: targets of backward jumps (so that a hook
+** set from outside, e.g. by a signal, can stop a loop) and targets of
+** branches taken after a helper call
+*/
+static void scan (JitState *J) {
+  Proto *p = J->p;
+  int pc;
+  for (pc = 0; pc < p->sizecode; pc++) {
+    Instruction i = p->code[pc];
+    switch (getBaseOp(GET_OPCODE(i))) {
+      case OP_JMP: {
+        if (GETARG_sBx(i) < 0) J->flags[pc + 1 + GETARG_sBx(i)] |= JF_CHECK;
+        break;
+      }
+      case OP_FORLOOP: case OP_FORPREP: {
+        J->flags[pc + 1 + GETARG_sBx(i)] |= JF_CHECK;
+        break;
+      }
+      case OP_EQ: case OP_LT: case OP_LE: case OP_EQK: case OP_TESTSET:
+      case OP_TFORLOOP: {
+        J->flags[pc + 2] |= JF_CHECK;
+        J->flags[pc + 2 + GETARG_sBx(p->code[pc + 1])] |= JF_CHECK;
+        break;
+      }
+      case OP_SETLIST: {
+        if (GETARG_C(i) == 0) J->flags[++pc] |= JF_DATA;
+        break;
+      }
+      case OP_CLOSURE: {
+        int nup = p->p[GETARG_Bx(i)]->nups;
+        while (nup--) J->flags[++pc] |= JF_DATA;
+        break;
+      }
+      default: break;
+    }
+  }
+}
+
+
+/*
+** whether a loop of the function has a call that is not compiled (or
+** another instruction whose code returns to `luaV_execute'): the machine
+** code would then be left and entered again on each iteration, which
+** costs more than it saves
+*/
+static int exitinloop (JitState *J) {
+  Proto *p = J->p;
+  int pc, j;
+  for (pc = 0; pc < p->sizecode; pc++) {
+    Instruction i = p->code[pc];
+    int target;
+    if (J->flags[pc] & JF_DATA) continue;
+    switch (getBaseOp(GET_OPCODE(i))) {
+      case OP_JMP: {
+        if (GETARG_sBx(i) >= 0) continue;
+        target = pc + 1 + GETARG_sBx(i);
+        break;
+      }
+      case OP_FORLOOP: target = pc + 1 + GETARG_sBx(i); break;
+      default: continue;
+    }
+    for (j = target; j < pc; j++) {
+      if (J->flags[j] & JF_DATA) continue;
+      switch (getBaseOp(GET_OPCODE(p->code[j]))) {
+        case OP_CALL: if (!fastcallat(p, j)) return 1; break;
+        case OP_CLOSURE: case OP_VARARG: return 1;
+        default: break;
+      }
+    }
+  }
+  return 0;
+}
+
+
+static void prologue (JitState *J) {
+  eb(J, 0x53);  /* push rbx */
+  eb(J, 0x41); eb(J, 0x54);  /* push r12 */
+  eb(J, 0x41); eb(J, 0x55);  /* push r13 */
+  eb(J, 0x49); eb(J, 0x89); eb(J, 0xFC);  /* mov r12, rdi */
+  oprm(J, 1, X_LOAD, RBASE, RSTATE, LOFF(base));
+  movimm(J, RCONST, cast(size_t, J->p->k));
+  eb(J, 0xFF); eb(J, 0xE6);  /* jmp rsi */
+  J->epilogue = J->n;
+  eb(J, 0x41); eb(J, 0x5D);  /* pop r13 */
+  eb(J, 0x41); eb(J, 0x5C);  /* pop r12 */
+  eb(J, 0x5B);  /* pop rbx */
+  eb(J, 0xC3);  /* ret */
+}
+
+/* }====================================================== */
+
+
+static JitCode *compile (lua_State *L, Proto *p) {
+  global_State *g = G(L);
+  int n = p->sizecode;
+  size_t bufsize = cast(size_t, n + 1) * MAXTEMPLATE;
+  size_t tmpsize = n * (sizeof(int) + 1 + 2 * sizeof(Fixup)) + bufsize;
+  size_t hdrsize, mapsize;
+  JitState J;
+  JitCode *jc;
+  void *tmp;
+  int pc;
+  if (n > MAXJITCODE || p->icache == NULL ||
+      sizeof(TValue) != 16 || offsetof(TValue, tt) != 8)
+    return NULL;
+  tmp = (*g->frealloc)(g->ud, NULL, 0, tmpsize);
+  if (tmp == NULL) return NULL;
+  J.p = p;
+  J.label = cast(int *, tmp);
+  J.fix = cast(Fixup *, J.label + n);
+  J.flags = cast(lu_byte *, J.fix + 2 * n);
+  J.buf = J.flags + n;
+  J.n = 0;
+  J.nfix = 0;
+  memset(J.flags, 0, n);
+  scan(&J);
+  if (exitinloop(&J)) {  /* not worth it */
+    (*g->frealloc)(g->ud, tmp, tmpsize, 0);
+    return NULL;
+  }
+  prologue(&J);
+  for (pc = 0; pc < n; pc++) {
+    int start = J.n;
+    J.pc = pc;
+    J.label[pc] = J.n;
+    if (J.flags[pc] & JF_DATA)
+      exitto(&J, pc);
+    else {
+      if (J.flags[pc] & JF_CHECK) hookcheck(&J, pc);
+      emitinstruction(&J, p->code[pc]);
+    }
+    lua_assert(J.n - start <= MAXTEMPLATE && J.nfix <= 2 * (pc + 1));
+    UNUSED(start);
+  }
+  for (pc = 0; pc < J.nfix; pc++)
+    patch(&J, J.fix[pc].pos, J.label[J.fix[pc].target]);
+  hdrsize = (sizeof(JitCode) + n * sizeof(int) + 15) & ~cast(size_t, 15);
+  mapsize = hdrsize + J.n;
+  jc = cast(JitCode *, mmap(NULL, mapsize, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  if (jc == cast(JitCode *, MAP_FAILED))
+    jc = NULL;
+  else {
+    jc->size = mapsize;
+    jc->mcode = cast(unsigned char *, jc) + hdrsize;
+    memcpy(jc->entry, J.label, n * sizeof(int));
+    memcpy(jc->mcode, J.buf, J.n);
+    if (mprotect(jc, mapsize, PROT_READ | PROT_EXEC) != 0) {
+      munmap(jc, mapsize);
+      jc = NULL;
+    }
+  }
+  (*g->frealloc)(g->ud, tmp, tmpsize, 0);
+  return jc;
+}
+
+
+/*
+** runs the machine code of `p' from `pc' (compiling it first if needed);
+** returns where the interpreter must go on
+*/
+const Instruction *luaJ_enter (lua_State *L, Proto *p, const Instruction *pc) {
+  JitCode *jc = p->jit;
+  if (jc == NULL) {
+    jc = p->jit = compile(L, p);
+    if (jc == NULL) {  /* cannot compile it? */
+      p->jithot = MAX_INT;  /* do not try again */
+      return pc;
+    }
+  }
+  if (L->hookmask & HOOKMASK)
+    return pc;  /* hooks need the interpreter */
+  return (*cast(JitFunc, jc->mcode))(L, jc->mcode + jc->entry[pc - p->code]);
+}
+
+
+void luaJ_free (lua_State *L, Proto *p) {
+  UNUSED(L);
+  if (p->jit != NULL)
+    munmap(p->jit, p->jit->size);
+}
+
+#endif
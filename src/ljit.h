@@ -0,0 +1,22 @@
+/*
+** $Id: ljit.h $
+** Baseline compiler from Lua bytecode to x86-64 machine code
+** See Copyright Notice in lua.h
+*/
+
+#ifndef ljit_h
+#define ljit_h
+
+
+#include "lobject.h"
+
+
+#if defined(LUA_USE_JIT)
+
+LUAI_FUNC const Instruction *luaJ_enter (lua_State *L, Proto *p,
+                                         const Instruction *pc);
+LUAI_FUNC void luaJ_free (lua_State *L, Proto *p);
+
+#endif
+
+#endif
@@ -0,0 +1,100 @@
+/*
+** $Id: ljumptab.h $
+** Jump table for the direct-threaded dispatch of `luaV_execute'
+** See Copyright Notice in lua.h
+*/
+
+/*
+** This file is included inside `luaV_execute' (lvm.c) when LUAI_JUMPTABLE
+** is defined. It replaces the single `switch' of the main loop with a
+** table of label addresses (a GCC extension), so that every instruction
+** ends with its own indirect jump to the next one.
+*/
+
+
+#undef vmhookcheck
+#undef vmfetch
+#undef vmdispatch
+#undef vmcase
+#undef vmbreak
+
+/*
+** While line or count hooks are on, `vmtab' points to `hooktab', whose
+** entries all lead to `L_hook' (which runs the hooks and then jumps
+** through `disptab'); otherwise instructions pay nothing for hooks.
+*/
+#define vmhookcheck()  \
+  (vmtab = (L->hookmask & (LUA_MASKLINE | LUA_MASKCOUNT)) ? hooktab : disptab)
+
+#define vmfetch()	{ \
+  i = *pc++; \
+  ra = RA(i); \
+  lua_assert(base == L->base && L->base == L->ci->base); \
+  lua_assert(base <= L->top && L->top <= L->stack + L->stacksize); \
+  lua_assert(L->top == L->ci->top || luaG_checkopenop(i)); \
+}
+
+#define vmdispatch(x)	goto *vmtab[x];
+
+#define vmcase(l)	L_##l:
+
+#define vmbreak		{ vmfetch(); vmdispatch(GET_OPCODE(i)); }
+
+
+/* WARNING: entries must be kept in ORDER OP (see lopcodes.h) */
+static const void *const disptab[NUM_OPCODES] = {
+&&L_OP_MOVE,
+&&L_OP_LOADK,
+&&L_OP_LOADBOOL,
+&&L_OP_LOADNIL,
+&&L_OP_GETUPVAL,
+&&L_OP_GETGLOBAL,
+&&L_OP_GETTABLE,
+&&L_OP_SETGLOBAL,
+&&L_OP_SETUPVAL,
+&&L_OP_SETTABLE,
+&&L_OP_NEWTABLE,
+&&L_OP_SELF,
+&&L_OP_ADD,
+&&L_OP_SUB,
+&&L_OP_MUL,
+&&L_OP_DIV,
+&&L_OP_MOD,
+&&L_OP_POW,
+&&L_OP_UNM,
+&&L_OP_NOT,
+&&L_OP_LEN,
+&&L_OP_CONCAT,
+&&L_OP_JMP,
+&&L_OP_EQ,
+&&L_OP_LT,
+&&L_OP_LE,
+&&L_OP_TEST,
+&&L_OP_TESTSET,
+&&L_OP_CALL,
+&&L_OP_TAILCALL,
+&&L_OP_RETURN,
+&&L_OP_FORLOOP,
+&&L_OP_FORPREP,
+&&L_OP_TFORLOOP,
+&&L_OP_SETLIST,
+&&L_OP_CLOSE,
+&&L_OP_CLOSURE,
+&&L_OP_VARARG,
+&&L_OP_EQK,
+&&L_OP_ADDK,
+&&L_OP_SUBK,
+&&L_OP_ADDF,
+&&L_OP_SUBF,
+&&L_OP_MULF,
+&&L_OP_ADDKF,
+&&L_OP_SUBKF,
+&&L_OP_GETTABLEI,
+&&L_OP_SETTABLEI
+};
+
+static const void *const hooktab[NUM_OPCODES] = {
+  [0 ... NUM_OPCODES-1] = &&L_hook
+};
+
+const void *const *vmtab;
@@ -248,8 +248,62 @@ static const luaL_Reg mathlib[] = {
 /*
 ** Open math library
 */
+/*
+** fast versions of the functions above (see `lua_setfastcfunction'),
+** for number arguments only; OP_CALL computes most of them inline (see
+** `lua_setintrinsic')
+*/
+
+#define fast1(name,op) \
+  static int fast_##name (lua_State *L) { \
+    if (lua_type(L, 1) != LUA_TNUMBER) return 0; \
+    lua_pushnumber(L, op(lua_tonumber(L, 1))); \
+    return 1; \
+  }
+
+#define fast2(name,op) \
+  static int fast_##name (lua_State *L) { \
+    if (lua_type(L, 1) != LUA_TNUMBER || lua_type(L, 2) != LUA_TNUMBER) \
+      return 0; \
+    lua_pushnumber(L, op(lua_tonumber(L, 1), lua_tonumber(L, 2))); \
+    return 1; \
+  }
+
+#define lmin(a,b)	((b) < (a) ? (b) : (a))
+#define lmax(a,b)	((b) > (a) ? (b) : (a))
+
+fast1(abs, fabs)
+fast1(ceil, ceil)
+fast1(floor, floor)
+fast1(sqrt, sqrt)
+fast1(sin, sin)
+fast1(cos, cos)
+fast1(exp, exp)
+fast1(log, log)
+fast2(fmod, fmod)
+fast2(min, lmin)
+fast2(max, lmax)
+
+
+static const luaL_RegFast mathfast[] = {
+  {"abs", fast_abs, 1, LUA_INTRABS},
+  {"ceil", fast_ceil, 1, LUA_INTRCEIL},
+  {"floor", fast_floor, 1, LUA_INTRFLOOR},
+  {"sqrt", fast_sqrt, 1, LUA_INTRSQRT},
+  {"sin", fast_sin, 1, LUA_INTRSIN},
+  {"cos", fast_cos, 1, LUA_INTRCOS},
+  {"exp", fast_exp, 1, LUA_INTREXP},
+  {"log", fast_log, 1, LUA_INTRLOG},
+  {"fmod", fast_fmod, 2, LUA_INTRFMOD},
+  {"min", fast_min, 2, LUA_INTRMIN},
+  {"max", fast_max, 2, LUA_INTRMAX},
+  {NULL, NULL, 0, 0}
+};
+
+
 LUALIB_API int luaopen_math (lua_State *L) {
   luaL_register(L, LUA_MATHLIBNAME, mathlib);
+  luaL_setfast(L, mathfast);
   lua_pushnumber(L, PI);
   lua_setfield(L, -2, "pi");
   lua_pushnumber(L, HUGE_VAL);
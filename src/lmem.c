@@ -84,3 +84,16 @@ void *luaM_realloc_ (lua_State *L, void *block, size_t osize, size_t nsize) {
   return block;
 }
 
+
+/*
+** like `luaM_realloc_' for a new block, but returns NULL instead of
+** raising an error when there is no memory for it
+*/
+void *luaM_tryalloc_ (lua_State *L, size_t size) {
+  global_State *g = G(L);
+  void *block = (*g->frealloc)(g->ud, NULL, 0, size);
+  if (block != NULL)
+    g->totalbytes += size;
+  return block;
+}
+
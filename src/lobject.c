@@ -24,7 +24,7 @@
 
 
 
-const TValue luaO_nilobject_ = {{NULL}, LUA_TNIL};
+const TValue luaO_nilobject_ = {NILFIELDS};
 
 
 /*
@@ -69,6 +69,21 @@ int luaO_log2 (unsigned int x) {
 }
 
 
+/*
+** converts `n' to an int when that is exact; -0 is left alone, as the
+** integer subtype cannot represent it
+*/
+int luaO_num2int (lua_Number n, int *p) {
+  int k;
+  lua_number2int(k, n);
+  if (luai_numeq(cast_num(k), n) && (k != 0 || !luai_numlt(1/n, 0))) {
+    *p = k;
+    return 1;
+  }
+  return 0;
+}
+
+
 int luaO_rawequalObj (const TValue *t1, const TValue *t2) {
   if (ttype(t1) != ttype(t2)) return 0;
   else switch (ttype(t1)) {
@@ -30,6 +30,15 @@
 #define LUA_TDEADKEY	(LAST_TAG+3)
 
 
+/*
+** Variant of LUA_TNUMBER for numbers held as C ints (the integer
+** subtype). It is internal to the core: `ttype' reports these values
+** as plain numbers and `nvalue' converts them to lua_Number.
+*/
+#define BIT_ISINT	(1 << 4)
+#define LUA_TNUMINT	(LUA_TNUMBER | BIT_ISINT)
+
+
 /*
 ** Union of all collectable objects
 */
@@ -52,6 +61,84 @@ typedef struct GCheader {
 
 
 
+#if defined(LUA_NANBOX)
+
+/*
+** NaN-boxed values: a TValue is a single 64-bit word. Every bit pattern
+** below NB_BOXMIN is an ordinary double (NaNs are stored in one canonical
+** form so that none of them reaches the boxed range). Above it, bits
+** 48-51 hold the type tag plus one and bits 0-47 hold the payload: a
+** pointer, a boolean or the 32 bits of an int. Number ints reuse the
+** LUA_TNUMBER tag, which is otherwise free because doubles are unboxed.
+*/
+typedef union {
+  LUAI_UINT64 u;
+  lua_Number n;
+} Value;
+
+#define TValuefields	Value value
+
+typedef struct lua_TValue {
+  TValuefields;
+} TValue;
+
+#define NB_QNAN		((LUAI_UINT64)0xFFF0 << 48)
+#define NB_BOXMIN	((LUAI_UINT64)0xFFF1 << 48)
+#define NB_PAYLOAD	(((LUAI_UINT64)1 << 48) - 1)
+#define NB_CANONNAN	((LUAI_UINT64)0x7FF8 << 48)
+
+#define nb_hitag(t)	(0xFFF0u | cast(unsigned int, (t) + 1))
+#define nb_box(t)	(cast(LUAI_UINT64, nb_hitag(t)) << 48)
+#define nb_tag(o)	cast(unsigned int, (o)->value.u >> 48)
+
+#define checktag(o,t)	(nb_tag(o) == nb_hitag(t))
+#define ttisnil(o)	((o)->value.u == nb_box(LUA_TNIL))
+#define ttisfloat(o)	((o)->value.u < NB_BOXMIN)
+#define ttisint(o)	checktag(o, LUA_TNUMBER)
+#define ttisnumber(o)	(ttisfloat(o) || ttisint(o))
+
+#define ttype(o)	(ttisfloat(o) ? LUA_TNUMBER : \
+			 cast_int(nb_tag(o) & 0xF) - 1)
+#define rttype(o)	(ttisint(o) ? LUA_TNUMINT : ttype(o))
+
+#define gcvalue_(o)	cast(GCObject *, cast(size_t, (o)->value.u & NB_PAYLOAD))
+#define pvalue_(o)	cast(void *, cast(size_t, (o)->value.u & NB_PAYLOAD))
+#define ivalue_(o)	cast_int(cast(unsigned int, (o)->value.u))
+#define bvalue_(o)	ivalue_(o)
+#define fltvalue_(o)	((o)->value.n)
+
+#define setboxed_(o,t,x)	((o)->value.u = nb_box(t) | (x))
+
+#define setnilvalue(obj) ((obj)->value.u = nb_box(LUA_TNIL))
+
+#define setnvalue(obj,x) \
+  { TValue *i_o=(obj); lua_Number i_n=(x); \
+    if (luai_numisnan(i_n)) i_o->value.u=NB_CANONNAN; else i_o->value.n=i_n; }
+
+#define setivalue(obj,x) \
+  setboxed_(obj, LUA_TNUMBER, cast(unsigned int, (x)))
+
+#define setpvalue(obj,x) \
+  setboxed_(obj, LUA_TLIGHTUSERDATA, cast(size_t, (x)))
+
+#define setbvalue(obj,x) \
+  setboxed_(obj, LUA_TBOOLEAN, cast(unsigned int, (x)))
+
+#define setgcovalue(L,obj,x,t) \
+  { TValue *i_o=(obj); setboxed_(i_o, t, cast(size_t, (x))); \
+    checkliveness(G(L),i_o); }
+
+#define setobj(L,obj1,obj2) \
+  { const TValue *o2=(obj2); TValue *o1=(obj1); \
+    o1->value = o2->value; \
+    checkliveness(G(L),o1); }
+
+#define setttype(obj,t) \
+  ((obj)->value.u = ((obj)->value.u & NB_PAYLOAD) | nb_box(t))
+
+#define NILFIELDS	{nb_box(LUA_TNIL)}
+
+#else
 
 /*
 ** Union of all Lua values
@@ -60,6 +147,7 @@ typedef union {
   GCObject *gc;
   void *p;
   lua_Number n;
+  ptrdiff_t i;  /* holds an int; pointer-wide so that stores fill the slot */
   int b;
 } Value;
 
@@ -75,93 +163,109 @@ typedef struct lua_TValue {
 } TValue;
 
 
-/* Macros to test type */
-#define ttisnil(o)	(ttype(o) == LUA_TNIL)
-#define ttisnumber(o)	(ttype(o) == LUA_TNUMBER)
-#define ttisstring(o)	(ttype(o) == LUA_TSTRING)
-#define ttistable(o)	(ttype(o) == LUA_TTABLE)
-#define ttisfunction(o)	(ttype(o) == LUA_TFUNCTION)
-#define ttisboolean(o)	(ttype(o) == LUA_TBOOLEAN)
-#define ttisuserdata(o)	(ttype(o) == LUA_TUSERDATA)
-#define ttisthread(o)	(ttype(o) == LUA_TTHREAD)
-#define ttislightuserdata(o)	(ttype(o) == LUA_TLIGHTUSERDATA)
+#define rttype(o)	((o)->tt)
+#define ttype(o)	(rttype(o) & ~BIT_ISINT)
 
-/* Macros to access values */
-#define ttype(o)	((o)->tt)
-#define gcvalue(o)	check_exp(iscollectable(o), (o)->value.gc)
-#define pvalue(o)	check_exp(ttislightuserdata(o), (o)->value.p)
-#define nvalue(o)	check_exp(ttisnumber(o), (o)->value.n)
-#define rawtsvalue(o)	check_exp(ttisstring(o), &(o)->value.gc->ts)
-#define tsvalue(o)	(&rawtsvalue(o)->tsv)
-#define rawuvalue(o)	check_exp(ttisuserdata(o), &(o)->value.gc->u)
-#define uvalue(o)	(&rawuvalue(o)->uv)
-#define clvalue(o)	check_exp(ttisfunction(o), &(o)->value.gc->cl)
-#define hvalue(o)	check_exp(ttistable(o), &(o)->value.gc->h)
-#define bvalue(o)	check_exp(ttisboolean(o), (o)->value.b)
-#define thvalue(o)	check_exp(ttisthread(o), &(o)->value.gc->th)
-
-#define l_isfalse(o)	(ttisnil(o) || (ttisboolean(o) && bvalue(o) == 0))
-
-/*
-** for internal debug only
-*/
-#define checkconsistency(obj) \
-  lua_assert(!iscollectable(obj) || (ttype(obj) == (obj)->value.gc->gch.tt))
-
-#define checkliveness(g,obj) \
-  lua_assert(!iscollectable(obj) || \
-  ((ttype(obj) == (obj)->value.gc->gch.tt) && !isdead(g, (obj)->value.gc)))
+#define checktag(o,t)	(rttype(o) == (t))
+#define ttisnil(o)	checktag(o, LUA_TNIL)
+#define ttisnumber(o)	(ttype(o) == LUA_TNUMBER)
+#define ttisint(o)	checktag(o, LUA_TNUMINT)
+#define ttisfloat(o)	checktag(o, LUA_TNUMBER)
 
+#define gcvalue_(o)	((o)->value.gc)
+#define pvalue_(o)	((o)->value.p)
+#define ivalue_(o)	cast_int((o)->value.i)
+#define bvalue_(o)	((o)->value.b)
+#define fltvalue_(o)	((o)->value.n)
 
-/* Macros to set values */
 #define setnilvalue(obj) ((obj)->tt=LUA_TNIL)
 
 #define setnvalue(obj,x) \
   { TValue *i_o=(obj); i_o->value.n=(x); i_o->tt=LUA_TNUMBER; }
 
+#define setivalue(obj,x) \
+  { TValue *i_o=(obj); i_o->value.i=cast(ptrdiff_t, (x)); i_o->tt=LUA_TNUMINT; }
+
 #define setpvalue(obj,x) \
   { TValue *i_o=(obj); i_o->value.p=(x); i_o->tt=LUA_TLIGHTUSERDATA; }
 
 #define setbvalue(obj,x) \
   { TValue *i_o=(obj); i_o->value.b=(x); i_o->tt=LUA_TBOOLEAN; }
 
-#define setsvalue(L,obj,x) \
+#define setgcovalue(L,obj,x,t) \
   { TValue *i_o=(obj); \
-    i_o->value.gc=cast(GCObject *, (x)); i_o->tt=LUA_TSTRING; \
+    i_o->value.gc=cast(GCObject *, (x)); i_o->tt=(t); \
     checkliveness(G(L),i_o); }
 
-#define setuvalue(L,obj,x) \
-  { TValue *i_o=(obj); \
-    i_o->value.gc=cast(GCObject *, (x)); i_o->tt=LUA_TUSERDATA; \
-    checkliveness(G(L),i_o); }
+#define setobj(L,obj1,obj2) \
+  { const TValue *o2=(obj2); TValue *o1=(obj1); \
+    o1->value = o2->value; o1->tt=o2->tt; \
+    checkliveness(G(L),o1); }
 
-#define setthvalue(L,obj,x) \
-  { TValue *i_o=(obj); \
-    i_o->value.gc=cast(GCObject *, (x)); i_o->tt=LUA_TTHREAD; \
-    checkliveness(G(L),i_o); }
+#define setttype(obj, tt) (rttype(obj) = (tt))
 
-#define setclvalue(L,obj,x) \
-  { TValue *i_o=(obj); \
-    i_o->value.gc=cast(GCObject *, (x)); i_o->tt=LUA_TFUNCTION; \
-    checkliveness(G(L),i_o); }
+#define NILFIELDS	{NULL}, LUA_TNIL
 
-#define sethvalue(L,obj,x) \
-  { TValue *i_o=(obj); \
-    i_o->value.gc=cast(GCObject *, (x)); i_o->tt=LUA_TTABLE; \
-    checkliveness(G(L),i_o); }
+#endif
 
-#define setptvalue(L,obj,x) \
-  { TValue *i_o=(obj); \
-    i_o->value.gc=cast(GCObject *, (x)); i_o->tt=LUA_TPROTO; \
-    checkliveness(G(L),i_o); }
 
+/* Macros to test type */
+#define ttisstring(o)	checktag(o, LUA_TSTRING)
+#define ttistable(o)	checktag(o, LUA_TTABLE)
+#define ttisfunction(o)	checktag(o, LUA_TFUNCTION)
+#define ttisboolean(o)	checktag(o, LUA_TBOOLEAN)
+#define ttisuserdata(o)	checktag(o, LUA_TUSERDATA)
+#define ttisthread(o)	checktag(o, LUA_TTHREAD)
+#define ttislightuserdata(o)	checktag(o, LUA_TLIGHTUSERDATA)
 
+/* Macros to access values */
+#define gcvalue(o)	check_exp(iscollectable(o), gcvalue_(o))
+#define pvalue(o)	check_exp(ttislightuserdata(o), pvalue_(o))
+#define nvalue(o)	check_exp(ttisnumber(o), \
+	ttisint(o) ? cast_num(ivalue_(o)) : fltvalue_(o))
+#define ivalue(o)	check_exp(ttisint(o), ivalue_(o))
+#define fltvalue(o)	check_exp(ttisfloat(o), fltvalue_(o))
+#define rawtsvalue(o)	check_exp(ttisstring(o), &gcvalue_(o)->ts)
+#define tsvalue(o)	(&rawtsvalue(o)->tsv)
+#define rawuvalue(o)	check_exp(ttisuserdata(o), &gcvalue_(o)->u)
+#define uvalue(o)	(&rawuvalue(o)->uv)
+#define clvalue(o)	check_exp(ttisfunction(o), &gcvalue_(o)->cl)
+#define hvalue(o)	check_exp(ttistable(o), &gcvalue_(o)->h)
+#define bvalue(o)	check_exp(ttisboolean(o), bvalue_(o))
+#define thvalue(o)	check_exp(ttisthread(o), &gcvalue_(o)->th)
 
+#define l_isfalse(o)	(ttisnil(o) || (ttisboolean(o) && bvalue(o) == 0))
 
-#define setobj(L,obj1,obj2) \
-  { const TValue *o2=(obj2); TValue *o1=(obj1); \
-    o1->value = o2->value; o1->tt=o2->tt; \
-    checkliveness(G(L),o1); }
+/*
+** for internal debug only
+*/
+#define checkconsistency(obj) \
+  lua_assert(!iscollectable(obj) || (ttype(obj) == gcvalue_(obj)->gch.tt))
+
+#define checkliveness(g,obj) \
+  lua_assert(!iscollectable(obj) || \
+  ((ttype(obj) == gcvalue_(obj)->gch.tt) && !isdead(g, gcvalue_(obj))))
+
+
+/* Macros to set values */
+
+/* sets a number, using the integer subtype when it holds `x' exactly */
+#define setnumvalue(obj,x) \
+  { TValue *n_o=(obj); lua_Number n_n=(x); int n_k; \
+    if (luaO_num2int(n_n, &n_k)) { setivalue(n_o, n_k); } \
+    else { setnvalue(n_o, n_n); } }
+
+#define setsvalue(L,obj,x)	setgcovalue(L,obj,x,LUA_TSTRING)
+
+#define setuvalue(L,obj,x)	setgcovalue(L,obj,x,LUA_TUSERDATA)
+
+#define setthvalue(L,obj,x)	setgcovalue(L,obj,x,LUA_TTHREAD)
+
+#define setclvalue(L,obj,x)	setgcovalue(L,obj,x,LUA_TFUNCTION)
+
+#define sethvalue(L,obj,x)	setgcovalue(L,obj,x,LUA_TTABLE)
+
+#define setptvalue(L,obj,x)	setgcovalue(L,obj,x,LUA_TPROTO)
 
 
 /*
@@ -183,8 +287,6 @@ typedef struct lua_TValue {
 #define setobj2n	setobj
 #define setsvalue2n	setsvalue
 
-#define setttype(obj, tt) (ttype(obj) = (tt))
-
 // 只有这些类型的数据 才是可回收的数据
 #define iscollectable(o)	(ttype(o) >= LUA_TSTRING)
 
@@ -228,6 +330,10 @@ typedef union Udata {
 /*
 ** Function Prototypes
 */
+/* native code of a function, generated by `luac -c' (see laot.h) */
+typedef const Instruction *(*AOTFunction) (lua_State *L,
+                                           const Instruction *pc);
+
 // 存放函数原型的数据结构
 typedef struct Proto {
   CommonHeader;
@@ -237,6 +343,7 @@ typedef struct Proto {
   // 在这个函数中定义的函数
   struct Proto **p;  /* functions defined inside the function */
   int *lineinfo;  /* map from opcodes to source lines */
+  int *icache;  /* inline caches (one per instruction; see lvm.c) */
   // 存放局部变量的数组
   struct LocVar *locvars;  /* information about local variables */
   TString **upvalues;  /* upvalue names */
@@ -245,11 +352,17 @@ typedef struct Proto {
   int sizek;  /* size of `k' */
   int sizecode;
   int sizelineinfo;
+  int sizeicache;
   int sizep;  /* size of `p' */
   int sizelocvars;
   int linedefined;
   int lastlinedefined;
   GCObject *gclist;
+  AOTFunction aot;  /* native code, or NULL */
+#if defined(LUA_USE_JIT)
+  struct JitCode *jit;  /* machine code, or NULL (see ljit.c) */
+  int jithot;  /* entries and back jumps left before compiling */
+#endif
   lu_byte nups;  /* number of upvalues */
   lu_byte numparams;
   lu_byte is_vararg;
@@ -301,6 +414,10 @@ typedef struct UpVal {
 typedef struct CClosure {
   ClosureHeader;
   lua_CFunction f;
+  lua_CFunction fastf;  /* version of `f' for OP_CALL, or NULL (see lvm.c) */
+  int fastnargs;  /* number of arguments `fastf' takes */
+  lu_byte iter;  /* kind of builtin table iterator `f' is, or 0 (see lvm.c) */
+  lu_byte intrinsic;  /* builtin `f' is (LUA_INTRABS & co.), or 0 */
   TValue upvalue[1];
 } CClosure;
 
@@ -329,7 +446,9 @@ typedef union Closure {
 typedef union TKey {
   struct {
     TValuefields;
+#if !defined(LUA_OPENHASH)
     struct Node *next;  /* for chaining */
+#endif
   } nk;
   TValue tvk;
 } TKey;
@@ -341,16 +460,45 @@ typedef struct Node {
 } Node;
 
 
+#if defined(LUA_PACKARRAY)
+/*
+** element of a packed array part: a number, or nil when its bits are
+** PACKEDNIL (a signaling NaN that no arithmetic produces)
+*/
+typedef union PackedNum {
+  lua_Number n;
+  LUAI_UINT64 u;
+} PackedNum;
+#endif
+
+
 typedef struct Table {
   CommonHeader;
-  lu_byte flags;  /* 1<<p means tagmethod(p) is not present */ 
   lu_byte lsizenode;  /* log2 of size of `node' array */
+  lu_byte watched;  /* may be in an `__index' chain (see `luaV_getmethod') */
+  lu_byte oldlsizenode;  /* log2 of size of `oldnode' array */
+  lu_byte sparse;  /* hash part found mostly empty (see `newkey') */
+  lu_byte frozen;  /* read-only (see `luaH_freeze'); then also `watched' */
+  lu_int32 flags;  /* 1<<p means tagmethod(p) is not present */
   struct Table *metatable;
   TValue *array;  /* array part */
   Node *node;
+#if defined(LUA_OPENHASH)
+  int nfree;  /* empty nodes that new keys may still take */
+#else
   Node *lastfree;  /* any free position is before this position */
+#endif
   GCObject *gclist;
   int sizearray;  /* size of `array' array */
+#if defined(LUA_PACKARRAY)
+  PackedNum *narray;  /* array part when packed (then `sizearray' is 0) */
+  int sizenarray;  /* size of `narray' array */
+#endif
+  int border;  /* last result of `luaH_getn', tried first next time */
+  int lastnext;  /* index of the last key `luaH_next' returned */
+  int *tmcache;  /* node of each tagmethod, if a metatable (see ltm.c) */
+  Node *oldnode;  /* hash part still being moved into `node', or NULL */
+  int nextmove;  /* first node of `oldnode' not moved yet */
 } Table;
 
 
@@ -379,6 +527,7 @@ LUAI_FUNC int luaO_log2 (unsigned int x);
 LUAI_FUNC int luaO_int2fb (unsigned int x);
 LUAI_FUNC int luaO_fb2int (int x);
 LUAI_FUNC int luaO_rawequalObj (const TValue *t1, const TValue *t2);
+LUAI_FUNC int luaO_num2int (lua_Number n, int *p);
 LUAI_FUNC int luaO_str2d (const char *s, lua_Number *result);
 LUAI_FUNC const char *luaO_pushvfstring (lua_State *L, const char *fmt,
                                                        va_list argp);
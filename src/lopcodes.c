@@ -52,6 +52,16 @@ const char *const luaP_opnames[NUM_OPCODES+1] = {
   "CLOSE",
   "CLOSURE",
   "VARARG",
+  "EQK",
+  "ADDK",
+  "SUBK",
+  "ADDF",
+  "SUBF",
+  "MULF",
+  "ADDKF",
+  "SUBKF",
+  "GETTABLEI",
+  "SETTABLEI",
   NULL
 };
 
@@ -99,5 +109,28 @@ const lu_byte luaP_opmodes[NUM_OPCODES] = {
  ,opmode(0, 0, OpArgN, OpArgN, iABC)		/* OP_CLOSE */
  ,opmode(0, 1, OpArgU, OpArgN, iABx)		/* OP_CLOSURE */
  ,opmode(0, 1, OpArgU, OpArgN, iABC)		/* OP_VARARG */
+ ,opmode(1, 0, OpArgR, OpArgK, iABC)		/* OP_EQK */
+ ,opmode(0, 1, OpArgR, OpArgK, iABC)		/* OP_ADDK */
+ ,opmode(0, 1, OpArgR, OpArgK, iABC)		/* OP_SUBK */
+ ,opmode(0, 1, OpArgK, OpArgK, iABC)		/* OP_ADDF */
+ ,opmode(0, 1, OpArgK, OpArgK, iABC)		/* OP_SUBF */
+ ,opmode(0, 1, OpArgK, OpArgK, iABC)		/* OP_MULF */
+ ,opmode(0, 1, OpArgR, OpArgK, iABC)		/* OP_ADDKF */
+ ,opmode(0, 1, OpArgR, OpArgK, iABC)		/* OP_SUBKF */
+ ,opmode(0, 1, OpArgR, OpArgK, iABC)		/* OP_GETTABLEI */
+ ,opmode(0, 0, OpArgK, OpArgK, iABC)		/* OP_SETTABLEI */
+};
+
+
+/* generic opcode of each instruction (differs only for quickened ones) */
+const lu_byte luaP_opbase[NUM_OPCODES] = {
+  OP_MOVE, OP_LOADK, OP_LOADBOOL, OP_LOADNIL, OP_GETUPVAL,
+  OP_GETGLOBAL, OP_GETTABLE, OP_SETGLOBAL, OP_SETUPVAL, OP_SETTABLE,
+  OP_NEWTABLE, OP_SELF, OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MOD, OP_POW,
+  OP_UNM, OP_NOT, OP_LEN, OP_CONCAT, OP_JMP, OP_EQ, OP_LT, OP_LE,
+  OP_TEST, OP_TESTSET, OP_CALL, OP_TAILCALL, OP_RETURN, OP_FORLOOP,
+  OP_FORPREP, OP_TFORLOOP, OP_SETLIST, OP_CLOSE, OP_CLOSURE, OP_VARARG,
+  OP_EQK, OP_ADDK, OP_SUBK,
+  OP_ADD, OP_SUB, OP_MUL, OP_ADDK, OP_SUBK, OP_GETTABLE, OP_SETTABLE
 };
 
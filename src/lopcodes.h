@@ -204,11 +204,24 @@ OP_SETLIST,/*	A B C	R(A)[(C-1)*FPF+i] := R(A+i), 1 <= i <= B	*/
 OP_CLOSE,/*	A 	close all variables in the stack up to (>=) R(A)*/
 OP_CLOSURE,/*	A Bx	R(A) := closure(KPROTO[Bx], R(A), ... ,R(A+n))	*/
 
-OP_VARARG/*	A B	R(A), R(A+1), ..., R(A+B-1) = vararg		*/
+OP_VARARG,/*	A B	R(A), R(A+1), ..., R(A+B-1) = vararg		*/
+
+OP_EQK,/*	A B C	if ((R(B) == Kst(C)) ~= A) then pc++		*/
+OP_ADDK,/*	A B C	R(A) := R(B) + Kst(C)				*/
+OP_SUBK,/*	A B C	R(A) := R(B) - Kst(C)				*/
+
+/* quickened forms (see note below); never produced by the compiler */
+OP_ADDF,/*	A B C	R(A) := RK(B) + RK(C)	(both floats)		*/
+OP_SUBF,/*	A B C	R(A) := RK(B) - RK(C)	(both floats)		*/
+OP_MULF,/*	A B C	R(A) := RK(B) * RK(C)	(both floats)		*/
+OP_ADDKF,/*	A B C	R(A) := R(B) + Kst(C)	(both floats)		*/
+OP_SUBKF,/*	A B C	R(A) := R(B) - Kst(C)	(both floats)		*/
+OP_GETTABLEI,/*	A B C	R(A) := R(B)[RK(C)]	(table, int key)	*/
+OP_SETTABLEI/*	A B C	R(A)[RK(B)] := RK(C)	(table, int key)	*/
 } OpCode;
 
 
-#define NUM_OPCODES	(cast(int, OP_VARARG) + 1)
+#define NUM_OPCODES	(cast(int, OP_SETTABLEI) + 1)
 
 
 
@@ -230,6 +243,17 @@ OP_VARARG/*	A B	R(A), R(A+1), ..., R(A+B-1) = vararg		*/
       (true or false).
 
   (*) All `skips' (pc++) assume that next instruction is a jump
+
+  (*) OP_EQK, OP_ADDK and OP_SUBK are specialized forms of OP_EQ, OP_ADD
+      and OP_SUB for a register against a constant; C is always an RK
+      constant, and for OP_ADDK/OP_SUBK a number.
+
+  (*) The quickened opcodes (OP_ADDF to OP_SETTABLEI) are written over a
+      generic instruction in `Proto::code' by `luaV_execute' once it has
+      seen operands of the kind named in the description; they take the
+      arguments of their generic form and turn back into it when their
+      guard fails. Dumps, code checks and the debug interface always see
+      the generic opcode (`getBaseOp').
 ===========================================================================*/
 
 
@@ -257,6 +281,10 @@ LUAI_DATA const lu_byte luaP_opmodes[NUM_OPCODES];
 #define testAMode(m)	(luaP_opmodes[m] & (1 << 6))
 #define testTMode(m)	(luaP_opmodes[m] & (1 << 7))
 
+LUAI_DATA const lu_byte luaP_opbase[NUM_OPCODES];
+
+#define getBaseOp(m)	(cast(OpCode, luaP_opbase[m]))
+
 
 LUAI_DATA const char *const luaP_opnames[NUM_OPCODES+1];  /* opcode names */
 
@@ -34,6 +34,10 @@ struct lua_longjmp;  /* defined in ldo.c */
 #define BASIC_STACK_SIZE        (2*LUA_MINSTACK)
 
 
+/* number of entries in the method cache (a power of 2) */
+#define MCACHESIZE	256
+
+
 
 typedef struct stringtable {
   GCObject **hash;
@@ -42,6 +46,24 @@ typedef struct stringtable {
 } stringtable;
 
 
+/*
+** an entry of the method cache: `value' is what `key' gives through
+** the `__index' chain of metatable `mt' (see `luaV_getmethod')
+*/
+typedef struct MCEntry {
+  Table *mt;
+  TString *key;
+  TValue value;
+  lu_int32 version;  /* entry is valid only while it equals `mcversion' */
+} MCEntry;
+
+#define mcentry(g,t,k) \
+	(&(g)->mcache[(IntPoint(t) ^ (k)->tsv.hash) & (MCACHESIZE-1)])
+
+#define mcvalid(g,e,t,k) \
+	((e)->version == (g)->mcversion && (e)->mt == (t) && (e)->key == (k))
+
+
 /*
 ** informations about a call
 */
@@ -98,6 +120,8 @@ typedef struct global_State {
   UpVal uvhead;  /* head of double-linked list of all open upvalues */
   struct Table *mt[NUM_TAGS];  /* metatables for basic types */
   TString *tmname[TM_N];  /* array with tag-method names */
+  lu_int32 mcversion;  /* current version of the method cache */
+  MCEntry mcache[MCACHESIZE];  /* method cache (see lvm.c) */
 } global_State;
 
 
@@ -888,6 +888,38 @@ static const luaL_Reg strlib[] = {
 };
 
 
+/*
+** fast versions of `len' and `byte' (see `lua_setfastcfunction'); `byte'
+** only for `s:byte(i)' with `i' inside `s'
+*/
+static int fast_len (lua_State *L) {
+  if (lua_type(L, 1) != LUA_TSTRING) return 0;
+  lua_pushinteger(L, lua_objlen(L, 1));
+  return 1;
+}
+
+
+static int fast_byte (lua_State *L) {
+  size_t l;
+  const char *s;
+  ptrdiff_t pos;
+  if (lua_type(L, 1) != LUA_TSTRING || lua_type(L, 2) != LUA_TNUMBER)
+    return 0;
+  s = lua_tolstring(L, 1, &l);
+  pos = posrelat(lua_tointeger(L, 2), l);
+  if (pos < 1 || (size_t)pos > l) return 0;  /* no values */
+  lua_pushinteger(L, uchar(s[pos-1]));
+  return 1;
+}
+
+
+static const luaL_RegFast strfast[] = {
+  {"byte", fast_byte, 2, LUA_INTRBYTE},
+  {"len", fast_len, 1, LUA_INTRLEN},
+  {NULL, NULL, 0, 0}
+};
+
+
 static void createmetatable (lua_State *L) {
   lua_createtable(L, 0, 1);  /* create metatable for strings */
   lua_pushliteral(L, "");  /* dummy string */
@@ -905,6 +937,7 @@ static void createmetatable (lua_State *L) {
 */
 LUALIB_API int luaopen_string (lua_State *L) {
   luaL_register(L, LUA_STRLIBNAME, strlib);
+  luaL_setfast(L, strfast);
 #if defined(LUA_COMPAT_GFIND)
   lua_getfield(L, -1, "gmatch");
   lua_setfield(L, -2, "gfind");
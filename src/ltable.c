@@ -16,11 +16,29 @@
 ** in its main position (i.e. the `original' position that its hash gives
 ** to it), then the colliding element is in its own main position.
 ** Hence even when the load factor reaches 100%, performance remains good.
+** With LUA_OPENHASH, the hash part uses open addressing instead: a key
+** is in the first node, from its main position on (and wrapping around),
+** that holds it or that is empty (nil key). A node whose value is nil
+** keeps its key, so that it goes on taking part in lookups, until a new
+** key takes the node. A table keeps at least one empty node, and
+** rehashes when new keys have taken about 3/4 of the nodes.
+** LUA_SIMDHASH adds to such a hash part a control byte per node (kept
+** right after the nodes): 7 bits of the hash of a string key, 0 for other
+** keys, or CTRLEMPTY. String lookups test the control bytes of GROUP
+** nodes at a time, and only look at the keys whose byte matches.
+** A large hash part (see LUAI_HASHINCR) grows incrementally: for a while
+** the table keeps its old hash part in `oldnode', where lookups go when
+** they miss in `node', and each insert of a new key moves some of the
+** old entries to `node' (see `moveold').
 */
 
 #include <math.h>
 #include <string.h>
 
+#if defined(LUA_SIMDHASH) && defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #define ltable_c
 #define LUA_CORE
 
@@ -33,6 +51,7 @@
 #include "lobject.h"
 #include "lstate.h"
 #include "ltable.h"
+#include "lvm.h"
 
 
 /*
@@ -47,6 +66,21 @@
 #define MAXASIZE	(1 << MAXBITS)
 
 
+/*
+** number of nodes of an old hash part moved by each new key; it makes
+** the move end long before the new hash part (at least twice as big)
+** can fill up
+*/
+#define MOVESTEP	4
+
+
+/*
+** how many times bigger than needed `luaH_freeze' may make a hash part
+** (2^FREEZEGROW) to take its string keys to distinct main positions
+*/
+#define FREEZEGROW	2
+
+
 #define hashpow2(t,n)      (gnode(t, lmod((n), sizenode(t))))
   
 #define hashstr(t,str)  hashpow2(t, (str)->tsv.hash)
@@ -64,6 +98,38 @@
 #define hashpointer(t,p)	hashmod(t, IntPoint(p))
 
 
+/*
+** node after `n' in the lookups for a key that is not in `n' (NULL after
+** the last one)
+*/
+#if defined(LUA_OPENHASH)
+#define probenext(t,n)	\
+	gnode(t, lmod(cast_int((n) - (t)->node) + 1, sizenode(t)))
+#define nextnode(t,n)	(ttisnil(gkey(n)) ? NULL : probenext(t,n))
+#else
+#define nextnode(t,n)	gnext(n)
+#endif
+
+
+#if defined(LUA_SIMDHASH)
+
+#define GROUP		16
+#define CTRLEMPTY	0x80
+
+#define ctrlof(t)	cast(lu_byte *, gnode(t, sizenode(t)))
+#define ctrlbyte(h)	cast(lu_byte, (h) >> 25)
+
+/* nodes allocated for a hash part of 2^lsize nodes and its control bytes */
+#define nodealloc(lsize)	(twoto(lsize) + \
+	cast_int((twoto(lsize) + GROUP + sizeof(Node) - 1) / sizeof(Node)))
+
+#else
+
+#define nodealloc(lsize)	twoto(lsize)
+
+#endif
+
+
 /*
 ** number of ints inside a lua_Number
 */
@@ -71,13 +137,35 @@
 
 
 
+#if defined(LUA_SIMDHASH)
+
+#define dummynode		(&dummy_.n)
+
+static const struct {
+  Node n;
+  lu_byte ctrl[GROUP];  /* control bytes of `n' (see `ctrlof') */
+} dummy_ = {
+  {{NILFIELDS}, {{NILFIELDS}}},
+  {CTRLEMPTY, CTRLEMPTY, CTRLEMPTY, CTRLEMPTY, CTRLEMPTY, CTRLEMPTY,
+   CTRLEMPTY, CTRLEMPTY, CTRLEMPTY, CTRLEMPTY, CTRLEMPTY, CTRLEMPTY,
+   CTRLEMPTY, CTRLEMPTY, CTRLEMPTY, CTRLEMPTY}
+};
+
+#else
+
 #define dummynode		(&dummynode_)
 
 static const Node dummynode_ = {
-  {{NULL}, LUA_TNIL},  /* value */
-  {{{NULL}, LUA_TNIL, NULL}}  /* key */
+  {NILFIELDS},  /* value */
+#if defined(LUA_OPENHASH)
+  {{NILFIELDS}}  /* key */
+#else
+  {{NILFIELDS, NULL}}  /* key */
+#endif
 };
 
+#endif
+
 
 /*
 ** hash for lua_Numbers
@@ -116,13 +204,219 @@ static Node *mainposition (const Table *t, const TValue *key) {
 }
 
 
+/*
+** makes `o' look like a table whose hash part is the old hash part of
+** `t', so that `mainposition' & co. work on it
+*/
+static void oldpart (Table *o, const Table *t) {
+  o->node = t->oldnode;
+  o->lsizenode = t->oldlsizenode;
+}
+
+
+/*
+** search in the old hash part, for keys not found in `node'
+*/
+static const TValue *getold (const Table *t, const TValue *key) {
+  Table o;
+  Node *n;
+  oldpart(&o, t);
+  n = mainposition(&o, key);
+  do {
+    if (luaO_rawequalObj(key2tval(n), key))
+      return gval(n);
+    else n = nextnode(&o, n);
+  } while (n);
+  return luaO_nilobject;
+}
+
+
+static const TValue *getstrold (const Table *t, TString *key) {
+  Table o;
+  Node *n;
+  oldpart(&o, t);
+  n = hashstr(&o, key);
+  do {
+    if (ttisstring(gkey(n)) && rawtsvalue(gkey(n)) == key)
+      return gval(n);
+    else n = nextnode(&o, n);
+  } while (n);
+  return luaO_nilobject;
+}
+
+
+#if defined(LUA_SIMDHASH)
+
+/*
+** bit i of the result is set when byte i of `g' (GROUP control bytes)
+** is `c'; `*empty' gets the same for CTRLEMPTY
+*/
+#if defined(__SSE2__)
+
+static unsigned int matchgroup (const lu_byte *g, lu_byte c,
+                                unsigned int *empty) {
+  __m128i v = _mm_loadu_si128(cast(const __m128i *, g));
+  *empty = cast(unsigned int, _mm_movemask_epi8(v));  /* only EMPTY has bit 7 */
+  return cast(unsigned int,
+              _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(cast(char, c)))));
+}
+
+#else
+
+static unsigned int matchgroup (const lu_byte *g, lu_byte c,
+                                unsigned int *empty) {
+  unsigned int m = 0;
+  int i;
+  *empty = 0;
+  for (i = 0; i < GROUP; i++) {
+    if (g[i] == c) m |= 1u << i;
+    else if (g[i] == CTRLEMPTY) *empty |= 1u << i;
+  }
+  return m;
+}
+
+#endif
+
+
+#if defined(__GNUC__)
+#define firstbit(m)	__builtin_ctz(m)
+#else
+static int firstbit (unsigned int m) {
+  int i = 0;
+  while (!(m & 1u)) { m >>= 1; i++; }
+  return i;
+}
+#endif
+
+
+/*
+** sets the control byte of node `i' and its copies after the last node,
+** which let a group start at any node
+*/
+static void setctrl (Table *t, int i, lu_byte c) {
+  lu_byte *ctrl = ctrlof(t);
+  int size = sizenode(t);
+  for (; i < size + GROUP; i += size)
+    ctrl[i] = c;
+}
+
+
+/*
+** the node of string `key' in the hash part, or NULL. Groups go in the
+** order of the linear probing, so an empty node in a group ends it.
+*/
+static Node *findstr (const Table *t, TString *key) {
+  const lu_byte *ctrl = ctrlof(t);
+  int mask = sizenode(t) - 1;
+  int pos = lmod(key->tsv.hash, sizenode(t));
+  lu_byte c = ctrlbyte(key->tsv.hash);
+  for (;;) {
+    unsigned int empty;
+    unsigned int m = matchgroup(ctrl + pos, c, &empty);
+    while (m) {
+      Node *n = gnode(t, (pos + firstbit(m)) & mask);
+      if (ttisstring(gkey(n)) && rawtsvalue(gkey(n)) == key)
+        return n;
+      m &= m - 1;
+    }
+    if (empty) return NULL;
+    pos = (pos + GROUP) & mask;
+  }
+}
+
+#endif
+
+
+#if defined(LUA_PACKARRAY)
+
+/*
+** A packed array part keeps its `sizenarray' elements unboxed in
+** `narray', right after a TValue into which lookups unpack the element
+** they return: such pointers are good only until the next lookup in the
+** same table. `luaH_setint' packs an array part made of numbers and
+** nils when one of its stores resizes it, and stores numbers and nils
+** in place; growing keeps it packed. Asking for a slot to store any
+** value into (`luaH_set', `luaH_setnum') or shrinking unpacks it.
+*/
+
+#define MINPACK		8	/* smallest array part worth packing */
+
+#define packedslot(t)	(cast(TValue *, (t)->narray) - 1)
+#define packedsize(n)	(sizeof(TValue) + cast(size_t, n) * sizeof(PackedNum))
+
+#define arraynil(t,i)	((t)->narray != NULL ? packedisnil(&(t)->narray[i]) \
+                                          : ttisnil(&(t)->array[i]))
+#define arrayslot(t,i)	((t)->narray != NULL ? getpacked(t, i) : &(t)->array[i])
+
+
+static const TValue *getpacked (const Table *t, int i) {
+  const PackedNum *p = &t->narray[i];
+  TValue *o = packedslot(t);
+  if (packedisnil(p)) setnilvalue(o);
+  else setnvalue(o, p->n);
+  return o;
+}
+
+
+/* turns the packed array part of `t' back into TValues */
+static void unpack (lua_State *L, Table *t) {
+  int n = t->sizenarray;
+  TValue *array = luaM_newvector(L, n, TValue);
+  int i;
+  for (i = 0; i < n; i++) {
+    if (packedisnil(&t->narray[i])) setnilvalue(&array[i]);
+    else setnvalue(&array[i], t->narray[i].n);
+  }
+  luaM_freemem(L, packedslot(t), packedsize(n));
+  t->narray = NULL;
+  t->sizenarray = 0;
+  t->array = array;
+  t->sizearray = n;
+}
+
+
+/* packs the array part of `t' when it holds numbers and nils only */
+static void pack (lua_State *L, Table *t) {
+  int n = t->sizearray;
+  int nums = 0;
+  int i;
+  TValue *block;
+  if (n < MINPACK) return;
+  for (i = 0; i < n; i++) {
+    if (ttisnumber(&t->array[i])) nums++;
+    else if (!ttisnil(&t->array[i])) return;
+  }
+  if (nums < n/2) return;  /* mostly empty */
+  block = cast(TValue *, luaM_malloc(L, packedsize(n)));
+  setnilvalue(block);
+  t->narray = cast(PackedNum *, block + 1);
+  for (i = 0; i < n; i++) {
+    if (ttisnil(&t->array[i])) setpackednil(&t->narray[i]);
+    else setpacked(&t->narray[i], nvalue(&t->array[i]));
+  }
+  luaM_freearray(L, t->array, n, TValue);
+  t->array = NULL;
+  t->sizearray = 0;
+  t->sizenarray = n;
+}
+
+#else
+
+#define arraynil(t,i)	ttisnil(&(t)->array[i])
+#define arrayslot(t,i)	(&(t)->array[i])
+
+#endif
+
+
 /*
 ** returns the index for `key' if `key' is an appropriate key to live in
 ** the array part of the table, -1 otherwise.
 */
 // 在数组中寻找一个key, 如果找到则返回在数组中的索引, 否则返回-1
 static int arrayindex (const TValue *key) {
-  if (ttisnumber(key)) {
+  if (ttisint(key))
+    return ivalue(key);
+  else if (ttisnumber(key)) {
     lua_Number n = nvalue(key);
     int k;
     lua_number2int(k, n);
@@ -133,69 +427,253 @@ static int arrayindex (const TValue *key) {
 }
 
 
+/* whether node `n' holds `key' (maybe dead already, which is ok in `next') */
+#define isnextkey(n,key) \
+  (luaO_rawequalObj(key2tval(n), key) || \
+   (ttype(gkey(n)) == LUA_TDEADKEY && iscollectable(key) && \
+    gcvalue(gkey(n)) == gcvalue(key)))
+
+
 /*
-** returns the index of a `key' for table traversals. First goes all
-** elements in the array part, then elements in the hash part. The
-** beginning of a traversal is signalled by -1.
+** returns the index of a `key' for table traversals when it needs no
+** search: for the beginning of a traversal (-1), a key in the array part
+** or the key that `luaH_next' returned last (tried first, so that a
+** traversal does not look its keys up again); -2 otherwise
 */
-// 根据key寻找索引(无论是在数字还是hash中)
-static int findindex (lua_State *L, Table *t, StkId key) {
+static int knownindex (Table *t, const TValue *key) {
   int i;
   if (ttisnil(key)) return -1;  /* first iteration */
   // 首先在数组部分进行查找
   i = arrayindex(key);
   // 如果index在数组范围内,则直接返回数组索引
-  if (0 < i && i <= t->sizearray)  /* is `key' inside array part? */
+  if (0 < i && i <= luaH_sizearray(t))  /* is `key' inside array part? */
 	// 返回的index需要-1是因为要跟C数组匹配上
     return i-1;  /* yes; that's the index (corrected to C) */
+  i = t->lastnext - luaH_sizearray(t);
+  if (cast(unsigned int, i) < cast(unsigned int, sizenode(t)) &&
+      isnextkey(gnode(t, i), key))
+    return t->lastnext;  /* the key `luaH_next' returned last */
+  return -2;
+}
+
+
+/*
+** returns the index of a `key' for table traversals. First goes all
+** elements in the array part, then elements in the hash part. The
+** beginning of a traversal is signalled by -1.
+*/
+// 根据key寻找索引(无论是在数字还是hash中)
+static int findindex (lua_State *L, Table *t, StkId key) {
+  int i = knownindex(t, key);
+  if (i != -2)
+    return i;
   else {
+    Node *n;
 	// 否则查找hash部分
-    Node *n = mainposition(t, key);
+    n = mainposition(t, key);
     do {  /* check whether `key' is somewhere in the chain */
       /* key may be dead already, but it is ok to use it in `next' */
-      if (luaO_rawequalObj(key2tval(n), key) ||
-            (ttype(gkey(n)) == LUA_TDEADKEY && iscollectable(key) &&
-             gcvalue(gkey(n)) == gcvalue(key))) {
+      if (isnextkey(n, key)) {
     	// 需要算出在hash部分中的偏移位置
         i = cast_int(n - gnode(t, 0));  /* key index in hash table */
         /* hash elements are numbered after array ones */
         // 这个偏移位置还要加上数组部分的长度,以便区分
-        return i + t->sizearray;
+        return i + luaH_sizearray(t);
       }
       // 没有找到的话,就继续寻找hash桶中的下一个元素
-      else n = gnext(n);
+      else n = nextnode(t, n);
     } while (n);
+    if (t->oldnode != NULL) {  /* then in the old hash part, numbered last */
+      Table o;
+      oldpart(&o, t);
+      n = mainposition(&o, key);
+      do {
+        if (isnextkey(n, key))
+          return cast_int(n - t->oldnode) + sizenode(t) + luaH_sizearray(t);
+        else n = nextnode(&o, n);
+      } while (n);
+    }
     luaG_runerror(L, "invalid key to " LUA_QL("next"));  /* key not found */
     return 0;  /* to avoid warnings */
   }
 }
 
-// 根据key寻找下一个不为nil的元素, 找到返回1,
-int luaH_next (lua_State *L, Table *t, StkId key) {
-  int i = findindex(L, t, key);  /* find original element */
-  for (i++; i < t->sizearray; i++) {  /* try first array part */
-    if (!ttisnil(&t->array[i])) {  /* a non-nil value? */
+/* the element after the one of index `i' (see `findindex'), as `luaH_next' */
+static int nextfrom (lua_State *L, Table *t, int i, StkId key) {
+  int asize = luaH_sizearray(t);
+  for (i++; i < asize; i++) {  /* try first array part */
+    if (!arraynil(t, i)) {  /* a non-nil value? */
       // i + 1存入key中
-      setnvalue(key, cast_num(i+1));
+      setivalue(key, i+1);
       // 将i的值复制到key + 1中(也就是i + 2)
-      setobj2s(L, key+1, &t->array[i]);
+      setobj2s(L, key+1, arrayslot(t, i));
       return 1;
     }
   }
   // 需要减去数组部分长度,
   // 这里居然使用的i++,不是node中的next,这不对吧????
   // 换言之,这里取到的不是在同一个hash桶上的node
-  for (i -= t->sizearray; i < sizenode(t); i++) {  /* then hash part */
+  for (i -= asize; i < sizenode(t); i++) {  /* then hash part */
     if (!ttisnil(gval(gnode(t, i)))) {  /* a non-nil value? */
       setobj2s(L, key, key2tval(gnode(t, i)));
       setobj2s(L, key+1, gval(gnode(t, i)));
+      t->lastnext = i + asize;
       return 1;
     }
   }
+  if (t->oldnode != NULL) {  /* then the old hash part */
+    for (i -= sizenode(t); i < twoto(t->oldlsizenode); i++) {
+      Node *n = &t->oldnode[i];
+      if (!ttisnil(gval(n))) {
+        setobj2s(L, key, key2tval(n));
+        setobj2s(L, key+1, gval(n));
+        return 1;
+      }
+    }
+  }
   return 0;  /* no more elements */
 }
 
 
+// 根据key寻找下一个不为nil的元素, 找到返回1,
+int luaH_next (lua_State *L, Table *t, StkId key) {
+  return nextfrom(L, t, findindex(L, t, key), key);
+}
+
+
+/*
+** `luaH_next' when it need not search for `key' (see `knownindex'), so
+** that it cannot raise an error; -1 otherwise, with nothing done
+*/
+int luaH_nextknown (lua_State *L, Table *t, StkId key) {
+  int i = knownindex(t, key);
+  return (i == -2) ? -1 : nextfrom(L, t, i, key);
+}
+
+
+#if defined(LUA_OPENHASH)
+
+/*
+** most keys that a hash part of 2^lsize nodes takes before growing: it
+** keeps one empty node (to end the lookups of absent keys) and about
+** 1/4 of them
+*/
+#define maxkeys(lsize)	(twoto(lsize) - 1 - (twoto(lsize) >> 2))
+
+
+/*
+** puts a new key into the hash part and returns its node (with a nil
+** value), or NULL if it is time to rehash. The key goes to the first node
+** of its lookups whose value is nil, which is either empty or a key that
+** left the table.
+*/
+static Node *place (lua_State *L, Table *t, const TValue *key) {
+  Node *mp = mainposition(t, key);
+  Node *n;
+  if (mp == dummynode) return NULL;
+  for (n = mp; !ttisnil(gval(n)); n = probenext(t, n))
+    lua_assert(!ttisnil(gkey(n)));
+  if (ttisnil(gkey(n))) {  /* an empty node? */
+    if (t->nfree == 0) return NULL;
+    t->nfree--;
+  }
+#if defined(LUA_SIMDHASH)
+  setctrl(t, cast_int(n - t->node),
+          ttisstring(key) ? ctrlbyte(rawtsvalue(key)->tsv.hash) : 0);
+#endif
+  setobj2t(L, key2tval(n), key);
+  return n;
+}
+
+#else
+
+// 在hash中寻找一个可用位置
+static Node *getfreepos (Table *t) {
+  while (t->lastfree-- > t->node) {
+    if (ttisnil(gkey(t->lastfree)))
+      return t->lastfree;
+  }
+  return NULL;  /* could not find a free place */
+}
+
+
+/*
+** puts a new key into the hash part and returns its node (with a nil
+** value), or NULL if there is no free place; first, check whether key's
+** main position is free. If not, check whether colliding node is in its
+** main position or not: if it is not, move colliding node to an empty
+** place and put new key in its main position; otherwise (colliding node
+** is in its main position), new key goes to an empty position.
+*/
+static Node *place (lua_State *L, Table *t, const TValue *key) {
+  // 根据key寻找在hash中的位置
+  Node *mp = mainposition(t, key);
+  // 如果该位置上已经有数据了(!ttisnil(gval(mp)), 或者找不到位置(mp == dummynode)
+  if (!ttisnil(gval(mp)) || mp == dummynode) {
+    Node *othern;
+    // 尝试着获取一个空闲位置
+    Node *n = getfreepos(t);  /* get a free place */
+    // 找不到空闲位置?
+    if (n == NULL)  /* cannot find a free place? */
+      return NULL;
+    lua_assert(n != dummynode);
+    othern = mainposition(t, key2tval(mp));
+    if (othern != mp) {  /* is colliding node out of its main position? */
+      /* yes; move colliding node into free position */
+      while (gnext(othern) != mp) othern = gnext(othern);  /* find previous */
+      gnext(othern) = n;  /* redo the chain with `n' in place of `mp' */
+      *n = *mp;  /* copy colliding node into free pos. (mp->next also goes) */
+      gnext(mp) = NULL;  /* now `mp' is free */
+      setnilvalue(gval(mp));
+    }
+    else {  /* colliding node is in its own main position */
+      /* new node will go into free position */
+      gnext(n) = gnext(mp);  /* chain new position */
+      gnext(mp) = n;
+      mp = n;
+    }
+  }
+  setobj2t(L, key2tval(mp), key);
+  lua_assert(ttisnil(gval(mp)));
+  return mp;
+}
+
+
+#endif
+
+
+/*
+** moves the next `n' nodes of the old hash part into `node', and frees
+** the old part after its last node. A moved node stays in the lookups
+** that go through it (it keeps its `next', or with LUA_OPENHASH a dead
+** key) but no key matches it, so that nothing can be stored there any
+** more.
+*/
+static void moveold (lua_State *L, Table *t, int n) {
+  int size = twoto(t->oldlsizenode);
+  for (; n > 0 && t->nextmove < size; n--) {
+    Node *old = &t->oldnode[t->nextmove++];
+    if (!ttisnil(gval(old))) {
+      Node *mp = place(L, t, key2tval(old));
+      lua_assert(mp != NULL);  /* `node' is large enough */
+      setobj2t(L, gval(mp), gval(old));
+      setnilvalue(gval(old));
+    }
+#if defined(LUA_OPENHASH)
+    if (!ttisnil(gkey(old)))
+      setttype(gkey(old), LUA_TDEADKEY);  /* keeps the lookups going */
+#else
+    setnilvalue(gkey(old));
+#endif
+  }
+  if (t->nextmove == size) {  /* all moved? */
+    luaM_freearray(L, t->oldnode, nodealloc(t->oldlsizenode), Node);
+    t->oldnode = NULL;
+  }
+}
+
+
+
 /*
 ** {=============================================================
 ** Rehash
@@ -252,14 +730,14 @@ static int numusearray (const Table *t, int *nums) {
   for (lg=0, ttlg=1; lg<=MAXBITS; lg++, ttlg*=2) {  /* for each slice */
     int lc = 0;  /* counter */
     int lim = ttlg;
-    if (lim > t->sizearray) {
-      lim = t->sizearray;  /* adjust upper limit */
+    if (lim > luaH_sizearray(t)) {
+      lim = luaH_sizearray(t);  /* adjust upper limit */
       if (i > lim)
         break;  /* no more elements to count */
     }
     /* count elements in range (2^(lg-1), 2^lg] */
     for (; i <= lim; i++) {
-      if (!ttisnil(&t->array[i-1]))
+      if (!arraynil(t, i-1))
         lc++;
     }
     nums[lg] += lc;
@@ -288,6 +766,17 @@ static int numusehash (const Table *t, int *nums, int *pnasize) {
 // 初始化table的数组部分
 static void setarrayvector (lua_State *L, Table *t, int size) {
   int i;
+#if defined(LUA_PACKARRAY)
+  if (t->narray != NULL) {  /* keep it packed */
+    TValue *block = cast(TValue *, luaM_realloc_(L, packedslot(t),
+                        packedsize(t->sizenarray), packedsize(size)));
+    t->narray = cast(PackedNum *, block + 1);
+    for (i=t->sizenarray; i<size; i++)
+      setpackednil(&t->narray[i]);
+    t->sizenarray = size;
+    return;
+  }
+#endif
   // 为什么这里用的是luaM_reallocvector,而后面的setnodevector中使用的是luaM_newvector
   luaM_reallocvector(L, t->array, t->sizearray, size, TValue);
   for (i=t->sizearray; i<size; i++)
@@ -296,44 +785,102 @@ static void setarrayvector (lua_State *L, Table *t, int size) {
 }
 
 // 初始化table的hash数组部分
+/* log2 of the size of a hash part for `size' (> 0) keys */
+static int nodelog (int size) {
+  // 为什么这里要计算log2,因为lsizenode就是log2值
+  int lsize = ceillog2(size);
+#if defined(LUA_OPENHASH)
+  while (maxkeys(lsize) < size) lsize++;
+#endif
+  return lsize;
+}
+
+
+/* empties all nodes of a hash part that is not the dummy node */
+static void clearnodes (Table *t) {
+  int size = sizenode(t);
+  int i;
+  // 初始化每个hash成员
+  for (i=0; i<size; i++) {
+    Node *n = gnode(t, i);
+    // 将next指针置NULL,将key/value置NIL
+#if !defined(LUA_OPENHASH)
+    gnext(n) = NULL;
+#endif
+    setnilvalue(gkey(n));
+    setnilvalue(gval(n));
+  }
+#if defined(LUA_SIMDHASH)
+  memset(ctrlof(t), CTRLEMPTY, size + GROUP);
+#endif
+#if defined(LUA_OPENHASH)
+  t->nfree = maxkeys(t->lsizenode);
+#else
+  // lastfree指针指向最后一个元素
+  t->lastfree = gnode(t, size);  /* all positions are free */
+#endif
+}
+
+
 static void setnodevector (lua_State *L, Table *t, int size) {
-  int lsize;
   if (size == 0) {  /* no elements to hash part? */
     t->node = cast(Node *, dummynode);  /* use common `dummynode' */
-    lsize = 0;
+    t->lsizenode = 0;
+#if defined(LUA_OPENHASH)
+    t->nfree = 0;
+#else
+    t->lastfree = t->node;  /* no free positions */
+#endif
   }
   else {
-    int i;
-    // 为什么这里要计算log2,因为lsizenode就是log2值
-    lsize = ceillog2(size);
+    int lsize = nodelog(size);
     // 过大了!!
     if (lsize > MAXBITS)
       luaG_runerror(L, "table overflow");
-    // 算原始值
-    size = twoto(lsize);
-    // 以上的ceillog2和twoto操作将size转换为大于size且为2的次幂的最小的数
+    // 以上的nodelog和twoto操作将size转换为大于size且为2的次幂的最小的数
     // 见setarrayvector中注释
-    t->node = luaM_newvector(L, size, Node);
-    // 初始化每个hash成员
-    for (i=0; i<size; i++) {
-      Node *n = gnode(t, i);
-      // 将next指针置NULL,将key/value置NIL
-      gnext(n) = NULL;
-      setnilvalue(gkey(n));
-      setnilvalue(gval(n));
+    t->node = luaM_newvector(L, nodealloc(lsize), Node);
+    t->lsizenode = cast_byte(lsize);
+    clearnodes(t);
+  }
+}
+
+/* t[key] = val for a key that was in `t' before a resize */
+static void reinsert (lua_State *L, Table *t, const TValue *key,
+                      const TValue *val) {
+#if defined(LUA_PACKARRAY)
+  if (t->narray != NULL && ttisnumber(val)) {
+    int k = arrayindex(key);
+    if (cast(unsigned int, k-1) < cast(unsigned int, t->sizenarray)) {
+      setpacked(&t->narray[k-1], nvalue(val));  /* keep it packed */
+      return;
     }
   }
-  // 存放尺寸和lastfree指针指向最后一个元素
-  t->lsizenode = cast_byte(lsize);
-  t->lastfree = gnode(t, size);  /* all positions are free */
+#endif
+  setobjt2t(L, luaH_set(L, t, key), val);
 }
 
+
 // 重新分配table的数组和hash部分的大小
 static void resize (lua_State *L, Table *t, int nasize, int nhsize) {
   int i;
-  int oldasize = t->sizearray;
-  int oldhsize = t->lsizenode;
-  Node *nold = t->node;  /* save old hash ... */
+  int oldasize;
+  int oldhsize;
+  Node *nold;
+  if (t->oldnode != NULL)  /* still moving to the current hash part? */
+    moveold(L, t, MAX_INT);  /* finish it */
+  oldasize = luaH_sizearray(t);
+  oldhsize = t->lsizenode;
+  nold = t->node;  /* save old hash ... */
+  if (nasize == oldasize && nold != dummynode &&
+      twoto(oldhsize) >= LUAI_HASHINCR && nodelog(nhsize) > oldhsize) {
+    /* large hash part that grows: move its entries little by little */
+    setnodevector(L, t, nhsize);
+    t->oldnode = nold;
+    t->oldlsizenode = cast_byte(oldhsize);
+    t->nextmove = 0;
+    return;
+  }
   // 如果新的数组部分大于老的数组部分,那么需要扩展数组尺寸
   if (nasize > oldasize)  /* array part must grow? */
     setarrayvector(L, t, nasize);
@@ -341,6 +888,10 @@ static void resize (lua_State *L, Table *t, int nasize, int nhsize) {
   setnodevector(L, t, nhsize);
   // 如果新的数组部分小于老的数组部分
   if (nasize < oldasize) {  /* array part must shrink? */
+#if defined(LUA_PACKARRAY)
+    if (t->narray != NULL)
+      unpack(L, t);
+#endif
     t->sizearray = nasize;
     /* re-insert elements from vanishing slice */
     // 遍历多出来的那部分
@@ -360,11 +911,11 @@ static void resize (lua_State *L, Table *t, int nasize, int nhsize) {
     Node *old = nold+i;
     // 将原来不为nil的元素重新插入hash中
     if (!ttisnil(gval(old)))
-      setobjt2t(L, luaH_set(L, t, key2tval(old)), gval(old));
+      reinsert(L, t, key2tval(old), gval(old));
   }
   // 释放旧的hash部分
   if (nold != dummynode)
-    luaM_freearray(L, nold, twoto(oldhsize), Node);  /* free old array */
+    luaM_freearray(L, nold, nodealloc(oldhsize), Node);  /* free old array */
 }
 
 // 数组部分重新分配
@@ -373,6 +924,19 @@ void luaH_resizearray (lua_State *L, Table *t, int nasize) {
   resize(L, t, nasize, nsize);
 }
 
+/*
+** whether key `ek' is appended to an array part that looks full (its
+** first, middle and last slots in use), which `rehash' then just doubles
+** without counting the keys in it
+*/
+static int isappend (const Table *t, const TValue *ek) {
+  int asize = luaH_sizearray(t);
+  return (ek != NULL && 0 < asize && asize <= MAXASIZE/2 &&
+          arrayindex(ek) == asize + 1 && !arraynil(t, 0) &&
+          !arraynil(t, asize/2) && !arraynil(t, asize - 1));
+}
+
+
 // 对table进行重新划分hash和数组部分的大小
 static void rehash (lua_State *L, Table *t, const TValue *ek) {
   int nasize, na;
@@ -380,8 +944,16 @@ static void rehash (lua_State *L, Table *t, const TValue *ek) {
   int nums[MAXBITS+1];  /* nums[i] = number of keys between 2^(i-1) and 2^i */
   int i;
   int totaluse;
+  if (t->oldnode != NULL)  /* still moving to the current hash part? */
+    moveold(L, t, MAX_INT);  /* finish it, so that `node' has all keys */
   // 首先清空nums数组
   for (i=0; i<=MAXBITS; i++) nums[i] = 0;  /* reset counts */
+  if (!t->sparse && isappend(t, ek)) {  /* growing array? */
+    nasize = 0;
+    resize(L, t, 2*luaH_sizearray(t), numusehash(t, nums, &nasize));
+    return;
+  }
+  t->sparse = 0;
   // 计算数组部分在每个范围中数据的数量,返回的nasize是数组部分数据的数量
   nasize = numusearray(t, nums);  /* count keys in array part */
   totaluse = nasize;  /* all those keys are integer keys */
@@ -389,8 +961,10 @@ static void rehash (lua_State *L, Table *t, const TValue *ek) {
   totaluse += numusehash(t, nums, &nasize);  /* count keys in hash part */
   /* count extra key */
   // 判断新key的范围
-  nasize += countint(ek, nums);
-  totaluse++;
+  if (ek != NULL) {
+    nasize += countint(ek, nums);
+    totaluse++;
+  }
   /* compute new size for array part */
   // 计算新的数组部分的大小
   na = computesizes(nums, &nasize);
@@ -410,10 +984,21 @@ Table *luaH_new (lua_State *L, int narray, int nhash) {
   Table *t = luaM_new(L, Table);
   luaC_link(L, obj2gco(t), LUA_TTABLE);
   t->metatable = NULL;
-  t->flags = cast_byte(~0);
+  t->flags = ~cast(lu_int32, 0);
+  t->watched = 0;
+  t->tmcache = NULL;
+  t->oldnode = NULL;
+  t->border = 0;
+  t->lastnext = 0;
+  t->sparse = 0;
+  t->frozen = 0;
   /* temporary values (kept only if some malloc fails) */
   t->array = NULL;
   t->sizearray = 0;
+#if defined(LUA_PACKARRAY)
+  t->narray = NULL;
+  t->sizenarray = 0;
+#endif
   t->lsizenode = 0;
   t->node = cast(Node *, dummynode);
   setarrayvector(L, t, narray);
@@ -424,63 +1009,181 @@ Table *luaH_new (lua_State *L, int narray, int nhash) {
 // 释放table
 void luaH_free (lua_State *L, Table *t) {
   if (t->node != dummynode)
-    luaM_freearray(L, t->node, sizenode(t), Node);
+    luaM_freearray(L, t->node, nodealloc(t->lsizenode), Node);
   luaM_freearray(L, t->array, t->sizearray, TValue);
+#if defined(LUA_PACKARRAY)
+  if (t->narray != NULL)
+    luaM_freemem(L, packedslot(t), packedsize(t->sizenarray));
+#endif
+  if (t->tmcache != NULL)
+    luaM_freearray(L, t->tmcache, TM_N, int);
+  if (t->oldnode != NULL)
+    luaM_freearray(L, t->oldnode, nodealloc(t->oldlsizenode), Node);
   luaM_free(L, t);
 }
 
-// 在hash中寻找一个可用位置
-static Node *getfreepos (Table *t) {
-  while (t->lastfree-- > t->node) {
-    if (ttisnil(gkey(t->lastfree)))
-      return t->lastfree;
+/*
+** removes every entry of `t' but keeps its array part and node vector,
+** so that refilling it up to those sizes allocates nothing
+*/
+void luaH_clear (lua_State *L, Table *t) {
+  int i;
+  luaV_touch(L, t);
+  for (i=0; i<t->sizearray; i++)
+    setnilvalue(&t->array[i]);
+#if defined(LUA_PACKARRAY)
+  for (i=0; i<t->sizenarray; i++)
+    setpackednil(&t->narray[i]);
+#endif
+  if (t->node != dummynode)
+    clearnodes(t);
+  if (t->oldnode != NULL) {  /* nothing left to move */
+    luaM_freearray(L, t->oldnode, nodealloc(t->oldlsizenode), Node);
+    t->oldnode = NULL;
   }
-  return NULL;  /* could not find a free place */
 }
 
+/*
+** resizes `t' to the entries it has, dropping the room left by removed
+** ones; like any resize, not to be done while traversing `t'. A frozen
+** table is compact already and keeps its layout.
+*/
+void luaH_compact (lua_State *L, Table *t) {
+  if (!t->frozen)
+    rehash(L, t, NULL);
+}
 
 
 /*
-** inserts a new key into a hash table; first, check whether key's main 
-** position is free. If not, check whether colliding node is in its main 
-** position or not: if it is not, move colliding node to an empty place and 
-** put new key in its main position; otherwise (colliding node is in its main 
-** position), new key goes to an empty position. 
+** returns a new table with the same entries, metatable and sizes as `t',
+** copying its array part and node vector as they are
 */
-// 向hash中插入一个新的key
-static TValue *newkey (lua_State *L, Table *t, const TValue *key) {
-  // 根据key寻找在hash中的位置
-  Node *mp = mainposition(t, key);
-  // 如果该位置上已经有数据了(!ttisnil(gval(mp)), 或者找不到位置(mp == dummynode)
-  if (!ttisnil(gval(mp)) || mp == dummynode) {
-    Node *othern;
-    // 尝试着获取一个空闲位置
-    Node *n = getfreepos(t);  /* get a free place */
-    // 找不到空闲位置?
-    if (n == NULL) {  /* cannot find a free place? */
-      rehash(L, t, key);  /* grow table */
-      return luaH_set(L, t, key);  /* re-insert key into grown table */
+Table *luaH_clone (lua_State *L, Table *t) {
+  Table *c = luaH_new(L, 0, 0);
+  if (t->oldnode != NULL)  /* still moving to the current hash part? */
+    moveold(L, t, MAX_INT);  /* finish it, so that `node' has all keys */
+  if (t->sizearray > 0) {
+    c->array = luaM_newvector(L, t->sizearray, TValue);
+    memcpy(c->array, t->array, t->sizearray * sizeof(TValue));
+    c->sizearray = t->sizearray;
+  }
+#if defined(LUA_PACKARRAY)
+  if (t->narray != NULL) {
+    TValue *block = cast(TValue *,
+                         luaM_malloc(L, packedsize(t->sizenarray)));
+    memcpy(block, packedslot(t), packedsize(t->sizenarray));
+    c->narray = cast(PackedNum *, block + 1);
+    c->sizenarray = t->sizenarray;
+  }
+#endif
+  if (t->node != dummynode) {
+    int size = nodealloc(t->lsizenode);
+    c->node = luaM_newvector(L, size, Node);
+    memcpy(c->node, t->node, size * sizeof(Node));
+    c->lsizenode = t->lsizenode;
+#if defined(LUA_OPENHASH)
+    c->nfree = t->nfree;
+#else
+    {
+      int i;
+      for (i = 0; i < sizenode(t); i++) {  /* rebase the chains */
+        Node *n = gnext(gnode(t, i));
+        gnext(gnode(c, i)) = (n == NULL) ? NULL : c->node + (n - t->node);
+      }
+      c->lastfree = c->node + (t->lastfree - t->node);
     }
-    lua_assert(n != dummynode);
-    othern = mainposition(t, key2tval(mp));
-    if (othern != mp) {  /* is colliding node out of its main position? */
-      /* yes; move colliding node into free position */
-      while (gnext(othern) != mp) othern = gnext(othern);  /* find previous */
-      gnext(othern) = n;  /* redo the chain with `n' in place of `mp' */
-      *n = *mp;  /* copy colliding node into free pos. (mp->next also goes) */
-      gnext(mp) = NULL;  /* now `mp' is free */
-      setnilvalue(gval(mp));
+#endif
+  }
+  c->metatable = t->metatable;
+  c->flags = t->flags;
+  c->border = t->border;
+  return c;
+}
+
+
+/*
+** log2 of the size, from 2^`lsize' up to 2^FREEZEGROW times that, of the
+** hash part where fewest string keys of `t' share their main positions
+*/
+static int freezesize (lua_State *L, const Table *t, int lsize) {
+  int maxl = (lsize + FREEZEGROW <= MAXBITS) ? lsize + FREEZEGROW : MAXBITS;
+  int best = lsize;
+  int bestc = MAX_INT;
+  lu_byte *used = luaM_newvector(L, twoto(maxl), lu_byte);
+  for (; lsize <= maxl && bestc > 0; lsize++) {
+    int c = 0;  /* string keys whose main position is taken already */
+    int i;
+    memset(used, 0, twoto(lsize));
+    for (i = 0; i < sizenode(t); i++) {
+      Node *n = gnode(t, i);
+      if (!ttisnil(gval(n)) && ttisstring(gkey(n))) {
+        int mp = lmod(rawtsvalue(gkey(n))->tsv.hash, twoto(lsize));
+        if (used[mp]) c++;
+        else used[mp] = 1;
+      }
     }
-    else {  /* colliding node is in its own main position */
-      /* new node will go into free position */
-      gnext(n) = gnext(mp);  /* chain new position */
-      gnext(mp) = n;
-      mp = n;
+    if (c < bestc) {
+      best = lsize;
+      bestc = c;
     }
   }
-  gkey(mp)->value = key->value; gkey(mp)->tt = key->tt;
+  luaM_freearray(L, used, twoto(maxl), lu_byte);
+  return best;
+}
+
+
+/*
+** makes `t' read-only: from now on any write to it raises an error (see
+** `luaV_touch'). It is compacted first, and its hash part rebuilt with
+** the size given by `freezesize' and the string keys inserted before
+** the others, so that a lookup finds each string key that does not share
+** its main position with the first probe.
+*/
+void luaH_freeze (lua_State *L, Table *t) {
+  if (t->frozen) return;
+  rehash(L, t, NULL);
+  if (t->oldnode != NULL)
+    moveold(L, t, MAX_INT);
+  if (t->node != dummynode) {
+    Node *nold = t->node;
+    int oldlsize = t->lsizenode;
+    int lsize = freezesize(L, t, oldlsize);
+    int pass, i;
+    t->node = luaM_newvector(L, nodealloc(lsize), Node);
+    t->lsizenode = cast_byte(lsize);
+    clearnodes(t);
+    for (pass = 1; pass >= 0; pass--) {  /* string keys first */
+      for (i = twoto(oldlsize) - 1; i >= 0; i--) {
+        Node *old = nold+i;
+        if (!ttisnil(gval(old)) &&
+            (pass ? ttisstring(gkey(old)) : !ttisstring(gkey(old))))
+          reinsert(L, t, key2tval(old), gval(old));
+      }
+    }
+    luaM_freearray(L, nold, nodealloc(oldlsize), Node);
+  }
+  t->frozen = 1;
+  t->watched = 1;  /* so that writes check `frozen' */
+}
+
+
+/*
+** inserts a new key into a hash table; returns NULL when it finds no free
+** place for it (see `place')
+*/
+// 向hash中插入一个新的key
+static TValue *newkey (lua_State *L, Table *t, const TValue *key) {
+  Node *mp;
+  t->flags = 0;  /* the key may name a tag method (see `gfasttm') */
+  if (t->oldnode != NULL)  /* moving to a new hash part? */
+    moveold(L, t, MOVESTEP);  /* one more step */
+  /* a hash part that the collector found `sparse' is compacted first */
+  mp = t->sparse ? NULL : place(L, t, key);
+  if (mp == NULL) {  /* cannot find a free place? */
+    rehash(L, t, key);  /* grow table */
+    return luaH_set(L, t, key);  /* re-insert key into grown table */
+  }
   luaC_barriert(L, t, key);
-  lua_assert(ttisnil(gval(mp)));
   return gval(mp);
 }
 
@@ -494,6 +1197,10 @@ const TValue *luaH_getnum (Table *t, int key) {
   // 只要比sizearray小,那么都在数组部分
   if (cast(unsigned int, key-1) < cast(unsigned int, t->sizearray))
     return &t->array[key-1];
+#if defined(LUA_PACKARRAY)
+  else if (cast(unsigned int, key-1) < cast(unsigned int, t->sizenarray))
+    return getpacked(t, key-1);
+#endif
   else {
 	// 否则在hash部分中
     lua_Number nk = cast_num(key);
@@ -501,8 +1208,13 @@ const TValue *luaH_getnum (Table *t, int key) {
     do {  /* check whether `key' is somewhere in the chain */
       if (ttisnumber(gkey(n)) && luai_numeq(nvalue(gkey(n)), nk))
         return gval(n);  /* that's it */
-      else n = gnext(n);
+      else n = nextnode(t, n);
     } while (n);
+    if (t->oldnode != NULL) {
+      TValue k;
+      setivalue(&k, key);
+      return getold(t, &k);
+    }
     return luaO_nilobject;
   }
 }
@@ -513,13 +1225,44 @@ const TValue *luaH_getnum (Table *t, int key) {
 */
 // 以字符串为key的查找函数
 const TValue *luaH_getstr (Table *t, TString *key) {
+#if defined(LUA_SIMDHASH)
+  Node *n = findstr(t, key);
+  if (n != NULL)
+    return gval(n);
+#else
   Node *n = hashstr(t, key);
   do {  /* check whether `key' is somewhere in the chain */
     if (ttisstring(gkey(n)) && rawtsvalue(gkey(n)) == key)
       return gval(n);  /* that's it */
-    else n = gnext(n);
+    else n = nextnode(t, n);
   } while (n);
-  return luaO_nilobject;
+#endif
+  return (t->oldnode != NULL) ? getstrold(t, key) : luaO_nilobject;
+}
+
+
+/*
+** search function for strings that keeps an inline cache up to date:
+** `*slot' receives the index of the node holding `key' (if it is there)
+*/
+const TValue *luaH_getstrcache (Table *t, TString *key, int *slot) {
+#if defined(LUA_SIMDHASH)
+  Node *n = findstr(t, key);
+  if (n != NULL) {
+    *slot = cast_int(n - t->node);
+    return gval(n);
+  }
+#else
+  Node *n = hashstr(t, key);
+  do {  /* check whether `key' is somewhere in the chain */
+    if (ttisstring(gkey(n)) && rawtsvalue(gkey(n)) == key) {
+      *slot = cast_int(n - t->node);
+      return gval(n);  /* that's it */
+    }
+    else n = nextnode(t, n);
+  } while (n);
+#endif
+  return (t->oldnode != NULL) ? getstrold(t, key) : luaO_nilobject;
 }
 
 
@@ -533,9 +1276,12 @@ const TValue *luaH_get (Table *t, const TValue *key) {
     case LUA_TSTRING: return luaH_getstr(t, rawtsvalue(key));
     case LUA_TNUMBER: {
       int k;
-      lua_Number n = nvalue(key);
+      lua_Number n;
+      if (ttisint(key))
+        return luaH_getnum(t, ivalue(key));
+      n = fltvalue(key);
       lua_number2int(k, n);
-      if (luai_numeq(cast_num(k), nvalue(key))) /* index is int? */
+      if (luai_numeq(cast_num(k), n)) /* index is int? */
         return luaH_getnum(t, k);  /* use specialized version */
       /* else go through */
       // 注意前面的不成功,再走近下面的hash部分
@@ -545,16 +1291,23 @@ const TValue *luaH_get (Table *t, const TValue *key) {
       do {  /* check whether `key' is somewhere in the chain */
         if (luaO_rawequalObj(key2tval(n), key))
           return gval(n);  /* that's it */
-        else n = gnext(n);
+        else n = nextnode(t, n);
       } while (n);
-      return luaO_nilobject;
+      return (t->oldnode != NULL) ? getold(t, key) : luaO_nilobject;
     }
   }
 }
 
 // 除了数字之外的key的set操作
 TValue *luaH_set (lua_State *L, Table *t, const TValue *key) {
-  const TValue *p = luaH_get(t, key);
+  const TValue *p;
+  luaV_touch(L, t);
+#if defined(LUA_PACKARRAY)
+  if (t->narray != NULL && ttisnumber(key) &&
+      cast(unsigned int, arrayindex(key)-1) < cast(unsigned int, t->sizenarray))
+    unpack(L, t);  /* caller may store any value there */
+#endif
+  p = luaH_get(t, key);
   t->flags = 0;
   if (p != luaO_nilobject)
 	// 如果存在值, 则返回值
@@ -570,21 +1323,81 @@ TValue *luaH_set (lua_State *L, Table *t, const TValue *key) {
 
 // 以数字为key的set操作
 TValue *luaH_setnum (lua_State *L, Table *t, int key) {
-  const TValue *p = luaH_getnum(t, key);
+  const TValue *p;
+  luaV_touch(L, t);
+#if defined(LUA_PACKARRAY)
+  if (cast(unsigned int, key-1) < cast(unsigned int, t->sizenarray))
+    unpack(L, t);  /* caller may store any value there */
+#endif
+  p = luaH_getnum(t, key);
   if (p != luaO_nilobject)
 	// 如果原来有数据, 直接返回了
     return cast(TValue *, p);
   else {
 	// 否则没有的话, 新创建一个出来
     TValue k;
-    setnvalue(&k, cast_num(key));
+    setivalue(&k, key);
     return newkey(L, t, &k);
   }
 }
 
+#if defined(LUA_PACKARRAY)
+/*
+** `newkey' for t[key] = v with a number `v' (and no barrier needed), which
+** the array part keeps packed if a resize moves `key' into it
+*/
+static void newnumkey (lua_State *L, Table *t, const TValue *key,
+                       const TValue *v) {
+  Node *mp;
+  if (t->oldnode != NULL)  /* moving to a new hash part? */
+    moveold(L, t, MOVESTEP);  /* one more step */
+  mp = t->sparse ? NULL : place(L, t, key);
+  if (mp == NULL) {  /* cannot find a free place? */
+    rehash(L, t, key);  /* grow table */
+    reinsert(L, t, key, v);
+  }
+  else
+    setobj2t(L, gval(mp), v);
+}
+#endif
+
+
+/*
+** t[key] = v for an integer key; unlike `luaH_setnum' it keeps a packed
+** array part packed when `v' is a number or nil (the caller still needs
+** the write barrier)
+*/
+void luaH_setint (lua_State *L, Table *t, int key, const TValue *v) {
+#if defined(LUA_PACKARRAY)
+  int asize = luaH_sizearray(t);
+  if (t->narray != NULL && (ttisnumber(v) || ttisnil(v))) {
+    if (cast(unsigned int, key-1) < cast(unsigned int, t->sizenarray)) {
+      luaV_touch(L, t);
+      if (ttisnil(v)) setpackednil(&t->narray[key-1]);
+      else setpacked(&t->narray[key-1], nvalue(v));
+      return;
+    }
+    else if (ttisnumber(v) && luaH_getnum(t, key) == luaO_nilobject) {
+      TValue k;
+      setivalue(&k, key);
+      luaV_touch(L, t);
+      newnumkey(L, t, &k, v);
+      return;
+    }
+  }
+#endif
+  setobj2t(L, luaH_setnum(L, t, key), v);
+#if defined(LUA_PACKARRAY)
+  if (t->narray == NULL && t->sizearray != asize)  /* array part resized? */
+    pack(L, t);
+#endif
+}
+
 // 以字符串为key的set操作
 TValue *luaH_setstr (lua_State *L, Table *t, TString *key) {
-  const TValue *p = luaH_getstr(t, key);
+  const TValue *p;
+  luaV_touch(L, t);
+  p = luaH_getstr(t, key);
   if (p != luaO_nilobject)
     return cast(TValue *, p);
   else {
@@ -619,21 +1432,17 @@ static int unbound_search (Table *t, unsigned int j) {
 }
 
 
-/*
-** Try to find a boundary in table `t'. A `boundary' is an integer index
-** such that t[i] is non-nil and t[i+1] is nil (and 0 if t[1] is nil).
-*/
-// 找到第一个"boundary"位置--它本身不为空, 而后一个元素为nil,
-int luaH_getn (Table *t) {
+/* binary search for a boundary, in the array part or after it */
+static int getn (Table *t) {
   // 首先取数组的大小
-  unsigned int j = t->sizearray;
-  if (j > 0 && ttisnil(&t->array[j - 1])) {
+  unsigned int j = luaH_sizearray(t);
+  if (j > 0 && arraynil(t, j - 1)) {
 	// 如果数组的最后一个元素为空
     /* there is a boundary in the array part: (binary) search for it */
     unsigned int i = 0;
     while (j - i > 1) {
       unsigned int m = (i+j)/2;
-      if (ttisnil(&t->array[m - 1])) j = m;
+      if (arraynil(t, m - 1)) j = m;
       else i = m;
     }
     return i;
@@ -645,6 +1454,30 @@ int luaH_getn (Table *t) {
 }
 
 
+/*
+** Try to find a boundary in table `t'. A `boundary' is an integer index
+** such that t[i] is non-nil and t[i+1] is nil (and 0 if t[1] is nil).
+** The last boundary found is checked first, together with its neighbours
+** (for tables that grow or shrink at the end, as with `t[#t+1] = v'),
+** so that writes to the table need not keep it up to date.
+*/
+// 找到第一个"boundary"位置--它本身不为空, 而后一个元素为nil,
+int luaH_getn (Table *t) {
+  int b = t->border;
+  if (b < MAX_INT - 1) {
+    if (b == 0 || !ttisnil(luaH_getnum(t, b))) {
+      if (ttisnil(luaH_getnum(t, b + 1)))
+        return b;  /* still a boundary */
+      if (ttisnil(luaH_getnum(t, b + 2)))
+        return t->border = b + 1;  /* one more element */
+    }
+    else if (b == 1 || !ttisnil(luaH_getnum(t, b - 1)))
+      return t->border = b - 1;  /* one element less */
+  }
+  return t->border = getn(t);
+}
+
+
 
 #if defined(LUA_DEBUG)
 
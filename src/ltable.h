@@ -13,21 +13,55 @@
 #define gnode(t,i)	(&(t)->node[i])
 #define gkey(n)		(&(n)->i_key.nk)
 #define gval(n)		(&(n)->i_val)
+#if !defined(LUA_OPENHASH)
 #define gnext(n)	((n)->i_key.nk.next)
+#endif
 
 #define key2tval(n)	(&(n)->i_key.tvk)
 
 
+#if defined(LUA_PACKARRAY)
+#define PACKEDNIL	((cast(LUAI_UINT64, 0x7FF4A5A5u) << 32) | 0xA5A5A5A5u)
+#define PACKEDNAN	(cast(LUAI_UINT64, 0x7FF8) << 48)
+
+#define luaH_sizearray(t)	((t)->sizearray + (t)->sizenarray)
+#define packedisnil(p)		((p)->u == PACKEDNIL)
+#define setpackednil(p)		((p)->u = PACKEDNIL)
+#define setpacked(p,x) \
+  { PackedNum *p_ = (p); p_->n = (x); \
+    if (p_->u == PACKEDNIL) p_->u = PACKEDNAN; }
+#else
+#define luaH_sizearray(t)	((t)->sizearray)
+#endif
+
+
+/*
+** string search through the inline cache `ic' (the index of the node
+** where the key was found last time); a hit does not hash the key
+*/
+#define luaH_getstrfast(t,key,ic) \
+  ((*(ic) < sizenode(t) && ttisstring(gkey(gnode(t, *(ic)))) && \
+    rawtsvalue(gkey(gnode(t, *(ic)))) == (key)) ? \
+   cast(const TValue *, gval(gnode(t, *(ic)))) : luaH_getstrcache(t, key, ic))
+
+
 LUAI_FUNC const TValue *luaH_getnum (Table *t, int key);
 LUAI_FUNC TValue *luaH_setnum (lua_State *L, Table *t, int key);
+LUAI_FUNC void luaH_setint (lua_State *L, Table *t, int key, const TValue *v);
 LUAI_FUNC const TValue *luaH_getstr (Table *t, TString *key);
+LUAI_FUNC const TValue *luaH_getstrcache (Table *t, TString *key, int *slot);
 LUAI_FUNC TValue *luaH_setstr (lua_State *L, Table *t, TString *key);
 LUAI_FUNC const TValue *luaH_get (Table *t, const TValue *key);
 LUAI_FUNC TValue *luaH_set (lua_State *L, Table *t, const TValue *key);
 LUAI_FUNC Table *luaH_new (lua_State *L, int narray, int lnhash);
 LUAI_FUNC void luaH_resizearray (lua_State *L, Table *t, int nasize);
 LUAI_FUNC void luaH_free (lua_State *L, Table *t);
+LUAI_FUNC void luaH_clear (lua_State *L, Table *t);
+LUAI_FUNC Table *luaH_clone (lua_State *L, Table *t);
+LUAI_FUNC void luaH_compact (lua_State *L, Table *t);
+LUAI_FUNC void luaH_freeze (lua_State *L, Table *t);
 LUAI_FUNC int luaH_next (lua_State *L, Table *t, StkId key);
+LUAI_FUNC int luaH_nextknown (lua_State *L, Table *t, StkId key);
 LUAI_FUNC int luaH_getn (Table *t);
 
 
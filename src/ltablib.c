@@ -266,13 +266,92 @@ static int sort (lua_State *L) {
 /* }====================================================== */
 
 
+static int tnew (lua_State *L) {
+  int narray = luaL_optint(L, 1, 0);
+  int nhash = luaL_optint(L, 2, 0);
+  luaL_argcheck(L, narray >= 0, 1, "negative size");
+  luaL_argcheck(L, nhash >= 0, 2, "negative size");
+  lua_createtable(L, narray, nhash);
+  return 1;
+}
+
+
+static int tclear (lua_State *L) {
+  luaL_checktype(L, 1, LUA_TTABLE);
+  lua_cleartable(L, 1);
+  return 0;
+}
+
+
+/*
+** pushes a copy of table `t' and of the tables among its values, down
+** to any depth; table 3 maps each table already copied to its copy
+*/
+static void deepcopy (lua_State *L, int t) {
+  int c;
+  lua_pushvalue(L, t);
+  lua_rawget(L, 3);
+  if (!lua_isnil(L, -1)) return;  /* copied already (a cycle or a share) */
+  lua_pop(L, 1);
+  luaL_checkstack(L, LUA_MINSTACK, "table too deep");
+  lua_clonetable(L, t);
+  c = lua_gettop(L);
+  lua_pushvalue(L, t);
+  lua_pushvalue(L, c);
+  lua_rawset(L, 3);
+  lua_pushnil(L);
+  while (lua_next(L, c)) {
+    if (lua_istable(L, -1)) {
+      deepcopy(L, lua_gettop(L));
+      lua_pushvalue(L, -3);  /* key */
+      lua_insert(L, -2);
+      lua_rawset(L, c);  /* replace value with its copy */
+    }
+    lua_pop(L, 1);
+  }
+}
+
+
+static int tcompact (lua_State *L) {
+  luaL_checktype(L, 1, LUA_TTABLE);
+  lua_compacttable(L, 1);
+  return 0;
+}
+
+
+static int tfreeze (lua_State *L) {
+  luaL_checktype(L, 1, LUA_TTABLE);
+  lua_freezetable(L, 1);
+  lua_settop(L, 1);
+  return 1;
+}
+
+
+static int tclone (lua_State *L) {
+  luaL_checktype(L, 1, LUA_TTABLE);
+  if (!lua_toboolean(L, 2))
+    lua_clonetable(L, 1);
+  else {
+    lua_settop(L, 2);
+    lua_newtable(L);  /* 3: copies made so far */
+    deepcopy(L, 1);
+  }
+  return 1;
+}
+
+
 static const luaL_Reg tab_funcs[] = {
+  {"clear", tclear},
+  {"clone", tclone},
+  {"compact", tcompact},
   {"concat", tconcat},
   {"foreach", foreach},
   {"foreachi", foreachi},
+  {"freeze", tfreeze},
   {"getn", getn},
   {"maxn", maxn},
   {"insert", tinsert},
+  {"new", tnew},
   {"remove", tremove},
   {"setn", setn},
   {"sort", sort},
@@ -12,6 +12,7 @@
 
 #include "lua.h"
 
+#include "lmem.h"
 #include "lobject.h"
 #include "lstate.h"
 #include "lstring.h"
@@ -46,21 +47,37 @@ void luaT_init (lua_State *L) {
 
 /*
 ** function to be used with macro "fasttm": optimized for absence of
-** tag methods
+** tag methods. A metatable also remembers in `tmcache' the node where
+** it last found each tag method, so a present one is found without
+** hashing its name (see `luaH_getstrfast')
 */
 const TValue *luaT_gettm (Table *events, TMS event, TString *ename) {
-  const TValue *tm = luaH_getstr(events, ename);
-  // 这里这个条件是什么原因??
-  lua_assert(event <= TM_EQ);
+  const TValue *tm = (events->tmcache != NULL)
+                   ? luaH_getstrfast(events, ename, &events->tmcache[event])
+                   : luaH_getstr(events, ename);
   if (ttisnil(tm)) {  /* no tag method? */
 	// 如果没有这个meta method，那么标记上，避免下一次再次进入这个函数
-    events->flags |= cast_byte(1u<<event);  /* cache this fact */
+    events->flags |= cast(lu_int32, 1)<<event;  /* cache this fact */
     return NULL;
   }
   else return tm;
 }
 
 
+/*
+** gives `mt' (which has just become a metatable) its `tmcache'; without
+** memory for it, `mt' just goes without one
+*/
+void luaT_newcache (lua_State *L, Table *mt) {
+  int *c = luaM_trynewvector(L, TM_N, int);
+  if (c != NULL) {
+    int i;
+    for (i = 0; i < TM_N; i++) c[i] = 0;
+    mt->tmcache = c;
+  }
+}
+
+
 const TValue *luaT_gettmbyobj (lua_State *L, const TValue *o, TMS event) {
   Table *mt;
   switch (ttype(o)) {
@@ -73,6 +90,10 @@ const TValue *luaT_gettmbyobj (lua_State *L, const TValue *o, TMS event) {
     default:
       mt = G(L)->mt[ttype(o)];
   }
-  return (mt ? luaH_getstr(mt, G(L)->tmname[event]) : luaO_nilobject);
+  if (mt != NULL) {
+    const TValue *tm = gfasttm(G(L), mt, event);
+    if (tm != NULL) return tm;
+  }
+  return luaO_nilobject;
 }
 
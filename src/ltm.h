@@ -20,7 +20,7 @@ typedef enum {
   TM_NEWINDEX,
   TM_GC,
   TM_MODE,
-  TM_EQ,  /* last tag method with `fast' access */
+  TM_EQ,
   TM_ADD,
   TM_SUB,
   TM_MUL,
@@ -38,8 +38,13 @@ typedef enum {
 
 
 
+/*
+** tag method `e' of metatable `et', or NULL; `flags' caches the absence
+** of each event until the next new key in `et'
+*/
 #define gfasttm(g,et,e) ((et) == NULL ? NULL : \
-  ((et)->flags & (1u<<(e))) ? NULL : luaT_gettm(et, e, (g)->tmname[e]))
+  ((et)->flags & (cast(lu_int32, 1)<<(e))) ? NULL : \
+  luaT_gettm(et, e, (g)->tmname[e]))
 
 #define fasttm(l,et,e)	gfasttm(G(l), et, e)
 
@@ -49,6 +54,7 @@ LUAI_DATA const char *const luaT_typenames[];
 LUAI_FUNC const TValue *luaT_gettm (Table *events, TMS event, TString *ename);
 LUAI_FUNC const TValue *luaT_gettmbyobj (lua_State *L, const TValue *o,
                                                        TMS event);
+LUAI_FUNC void luaT_newcache (lua_State *L, Table *mt);
 LUAI_FUNC void luaT_init (lua_State *L);
 
 #endif
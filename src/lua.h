@@ -296,6 +296,38 @@ LUA_API void  (lua_rawset) (lua_State *L, int idx);
 LUA_API void  (lua_rawseti) (lua_State *L, int idx, int n);
 LUA_API int   (lua_setmetatable) (lua_State *L, int objindex);
 LUA_API int   (lua_setfenv) (lua_State *L, int idx);
+LUA_API void  (lua_setfastcfunction) (lua_State *L, int idx,
+                                      lua_CFunction fast, int nargs);
+LUA_API void  (lua_cleartable) (lua_State *L, int idx);
+LUA_API void  (lua_clonetable) (lua_State *L, int idx);
+LUA_API void  (lua_compacttable) (lua_State *L, int idx);
+LUA_API void  (lua_freezetable) (lua_State *L, int idx);
+LUA_API void  (lua_setiterator) (lua_State *L, int idx, int kind);
+LUA_API void  (lua_setintrinsic) (lua_State *L, int idx, int kind);
+
+/*
+** kinds of table iterators for `lua_setiterator'
+*/
+#define LUA_ITERNEXT	1	/* next(t, k) */
+#define LUA_ITERIPAIRS	2	/* the iterator function of ipairs(t) */
+
+/*
+** builtins for `lua_setintrinsic'; those before LUA_INTRFMOD take one
+** argument, the others two
+*/
+#define LUA_INTRABS	1	/* math.abs(x) */
+#define LUA_INTRCEIL	2	/* math.ceil(x) */
+#define LUA_INTRFLOOR	3	/* math.floor(x) */
+#define LUA_INTRSQRT	4	/* math.sqrt(x) */
+#define LUA_INTRSIN	5	/* math.sin(x) */
+#define LUA_INTRCOS	6	/* math.cos(x) */
+#define LUA_INTREXP	7	/* math.exp(x) */
+#define LUA_INTRLOG	8	/* math.log(x) */
+#define LUA_INTRLEN	9	/* string.len(s) */
+#define LUA_INTRFMOD	10	/* math.fmod(x, y) */
+#define LUA_INTRMIN	11	/* math.min(x, y) */
+#define LUA_INTRMAX	12	/* math.max(x, y) */
+#define LUA_INTRBYTE	13	/* string.byte(s, i) */
 
 
 /*
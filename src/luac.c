@@ -29,6 +29,7 @@
 static int listing=0;			/* list bytecodes? */
 static int dumping=1;			/* dump bytecodes? */
 static int stripping=0;			/* strip debug information? */
+static const char* module=NULL;		/* write C code for this module? */
 static char Output[]={ OUTPUT };	/* default output file name */
 static const char* output=Output;	/* actual output file name */
 static const char* progname=PROGNAME;	/* actual program name */
@@ -84,6 +85,11 @@ static int doargs(int argc, char* argv[])
   }
   else if (IS("-"))			/* end of options; use stdin */
    break;
+  else if (IS("-c"))			/* C code */
+  {
+   module=argv[++i];
+   if (module==NULL || *module==0) usage(LUA_QL("-c") " needs argument");
+  }
   else if (IS("-l"))			/* list */
    ++listing;
   else if (IS("-o"))			/* output file */
@@ -150,6 +156,23 @@ static int writer(lua_State* L, const void* p, size_t size, void* u)
  return (fwrite(p,size,1,(FILE*)u)!=1) && (size!=0);
 }
 
+typedef struct Chunk {
+ char* b;
+ size_t n;
+} Chunk;
+
+static int bufwriter(lua_State* L, const void* p, size_t size, void* u)
+{
+ Chunk* c=(Chunk*)u;
+ char* b=realloc(c->b,c->n+size);
+ UNUSED(L);
+ if (b==NULL) return 1;
+ memcpy(b+c->n,p,size);
+ c->b=b;
+ c->n+=size;
+ return 0;
+}
+
 struct Smain {
  int argc;
  char** argv;
@@ -174,9 +197,21 @@ static int pmain(lua_State* L)
  {
   FILE* D= (output==NULL) ? stdout : fopen(output,"wb");
   if (D==NULL) cannot("open");
-  lua_lock(L);
-  luaU_dump(L,f,writer,D,stripping);
-  lua_unlock(L);
+  if (module!=NULL)
+  {
+   Chunk c={NULL,0};
+   lua_lock(L);
+   if (luaU_dump(L,f,bufwriter,&c,stripping)!=0) fatal("not enough memory");
+   lua_unlock(L);
+   luaU_aot(f,module,c.b,c.n,D);
+   free(c.b);
+  }
+  else
+  {
+   lua_lock(L);
+   luaU_dump(L,f,writer,D,stripping);
+   lua_unlock(L);
+  }
   if (ferror(D)) cannot("write");
   if (fclose(D)) cannot("close");
  }
@@ -379,6 +379,50 @@
 #endif
 
 
+/*
+@@ LUAI_JUMPTABLE makes the interpreter dispatch instructions through a
+@* table of label addresses instead of a single `switch'.
+** CHANGE it (define LUA_NOJUMPTABLE) if your compiler does not support
+** GCC's labels as values or if you want the portable dispatch. The
+** jump table gives each opcode its own indirect branch, which modern
+** branch predictors handle much better than one shared branch.
+*/
+#if defined(__GNUC__) && !defined(LUA_ANSI) && !defined(LUA_NOJUMPTABLE)
+#define LUAI_JUMPTABLE
+#endif
+
+
+/*
+@@ LUAI_QUICKEN lets the interpreter rewrite generic instructions into
+@* type-specialized forms after seeing the types of their operands.
+** CHANGE it (define LUA_NOQUICKEN) if function code must never be
+** written to after compilation.
+*/
+#if !defined(LUA_NOQUICKEN)
+#define LUAI_QUICKEN
+#endif
+
+
+/*
+@@ LUA_USE_JIT adds a baseline compiler from bytecode to x86-64 code.
+** CHANGE it (define it) to run hot Lua functions as machine code. It
+** needs GCC on x86-64 with POSIX `mmap', the default value layout (not
+** LUA_NANBOX) and a C build (errors cannot unwind machine code as C++
+** exceptions). Line and count hooks always use the interpreter.
+@@ LUAI_JITHOT is how many backward jumps a function takes before it is
+@* compiled.
+*/
+/* #define LUA_USE_JIT */
+
+#if defined(LUA_USE_JIT)
+#if !defined(__GNUC__) || !defined(__x86_64__) || defined(__cplusplus) || \
+    !defined(LUA_USE_POSIX) || defined(LUA_NANBOX)
+#error "LUA_USE_JIT needs C with GCC, x86-64, POSIX and the default layout"
+#endif
+#define LUAI_JITHOT	64
+#endif
+
+
 /*
 @@ LUAI_BITSINT defines the number of bits in an int.
 ** CHANGE here if Lua cannot automatically detect the number of bits of
@@ -479,6 +523,44 @@
 #define LUAI_MAXUPVALUES	60
 
 
+/*
+@@ LUAI_HASHINCR is the size of a hash part from which it grows
+@* incrementally.
+** CHANGE it if the inserts into large tables must take shorter (use a
+** smaller value) or if large tables must not carry two hash parts at
+** once (use a larger one). When a hash part of at least this many nodes
+** fills up, the table gets a new, larger one and moves its entries there
+** a few at a time, on the following inserts of new keys, instead of all
+** at once.
+*/
+#define LUAI_HASHINCR		(1 << 16)
+
+
+/*
+@@ LUA_OPENHASH keeps the hash part of tables in open addressing.
+** CHANGE it (define it) to look keys up by linear probing from their
+** main position instead of following chains of `next' pointers: probes
+** read consecutive nodes, and nodes lose their pointer (8 bytes fewer
+** on 64-bit machines). The hash part then stays at most about 3/4 full,
+** so it may take more nodes for the same keys.
+*/
+/* #define LUA_OPENHASH */
+
+
+/*
+@@ LUA_SIMDHASH gives the open-addressing hash part a control byte per
+@* node, so that string lookups test 16 nodes at a time.
+** CHANGE it (define it) to look up string keys with SSE2 when the
+** compiler targets it (and with a portable loop otherwise). It implies
+** LUA_OPENHASH.
+*/
+/* #define LUA_SIMDHASH */
+
+#if defined(LUA_SIMDHASH) && !defined(LUA_OPENHASH)
+#define LUA_OPENHASH
+#endif
+
+
 /*
 @@ LUAL_BUFFERSIZE is the buffer size used by the lauxlib buffer system.
 */
@@ -508,6 +590,43 @@
 #define LUAI_UACNUMBER	double
 
 
+/*
+@@ LUA_NANBOX packs each tagged value into the 8 bytes of a double.
+** CHANGE it (define it) to halve the size of stack slots, array parts
+** and hash nodes. It needs LUA_NUMBER to be an IEEE double, a 64-bit
+** unsigned type in LUAI_UINT64, and pointers that fit in 48 bits
+** (true for 32-bit platforms and for x86-64 and AArch64 user space).
+*/
+/* #define LUA_NANBOX */
+
+#if defined(LUA_NANBOX)
+#if !defined(LUA_NUMBER_DOUBLE)
+#error "LUA_NANBOX requires lua_Number to be a double"
+#endif
+#define LUAI_UINT64	unsigned long long
+#endif
+
+
+/*
+@@ LUA_PACKARRAY lets tables keep an array part of numbers unboxed.
+** CHANGE it (define it) to store the array part of a table that holds
+** only numbers (and nils) as a plain vector of lua_Numbers, half the
+** size of the TValues; storing any other value unboxes it again. It
+** needs LUA_NUMBER to be an IEEE double and cannot be used together
+** with LUA_NANBOX (where TValues are already that small).
+*/
+/* #define LUA_PACKARRAY */
+
+#if defined(LUA_PACKARRAY)
+#if !defined(LUA_NUMBER_DOUBLE) || defined(LUA_NANBOX)
+#error "LUA_PACKARRAY requires lua_Number to be a double and no LUA_NANBOX"
+#endif
+#if !defined(LUAI_UINT64)
+#define LUAI_UINT64	unsigned long long
+#endif
+#endif
+
+
 /*
 @@ LUA_NUMBER_SCAN is the format for reading numbers.
 @@ LUA_NUMBER_FMT is the format for writing numbers.
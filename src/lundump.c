@@ -93,6 +93,7 @@ static void LoadCode(LoadState* S, Proto* f)
  f->code=luaM_newvector(S->L,n,Instruction);
  f->sizecode=n;
  LoadVector(S,f->code,n,sizeof(Instruction));
+ luaF_newicache(S->L,f);
 }
 
 static Proto* LoadFunction(LoadState* S, TString* p);
@@ -117,7 +118,7 @@ static void LoadConstants(LoadState* S, Proto* f)
    	setbvalue(o,LoadChar(S)!=0);
 	break;
    case LUA_TNUMBER:
-	setnvalue(o,LoadNumber(S));
+	setnumvalue(o,LoadNumber(S));
 	break;
    case LUA_TSTRING:
 	setsvalue2n(S->L,o,LoadString(S));
@@ -208,6 +209,34 @@ Proto* luaU_undump (lua_State* L, ZIO* Z, Mbuffer* buff, const char* name)
  return LoadFunction(&S,luaS_newliteral(L,"=?"));
 }
 
+static int MatchAOT(const Proto* f, const int* sizecode, int n, int i)
+{
+ int j;
+ if (i<0 || i>=n || f->sizecode!=sizecode[i]) return -1;
+ i++;
+ for (j=0; j<f->sizep; j++) i=MatchAOT(f->p[j],sizecode,n,i);
+ return i;
+}
+
+static int SetAOT(Proto* f, const AOTFunction* aot, int i)
+{
+ int j;
+ f->aot=aot[i++];
+ for (j=0; j<f->sizep; j++) i=SetAOT(f->p[j],aot,i);
+ return i;
+}
+
+/*
+** attach native code made by "luac -c" to a chunk; its n functions (and
+** their sizes of code) come in the order of a preorder walk of the chunk
+*/
+int luaU_setaot (Proto* f, const AOTFunction* aot, const int* sizecode, int n)
+{
+ if (MatchAOT(f,sizecode,n,0)!=n) return 0;	/* not the same chunk */
+ SetAOT(f,aot,0);
+ return 1;
+}
+
 /*
 * make header
 */
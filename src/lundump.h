@@ -13,6 +13,9 @@
 /* load one chunk; from lundump.c */
 LUAI_FUNC Proto* luaU_undump (lua_State* L, ZIO* Z, Mbuffer* buff, const char* name);
 
+/* attach native code to a chunk; from lundump.c */
+LUAI_FUNC int luaU_setaot (Proto* f, const AOTFunction* aot, const int* sizecode, int n);
+
 /* make header; from lundump.c */
 LUAI_FUNC void luaU_header (char* h);
 
@@ -22,6 +25,9 @@ LUAI_FUNC int luaU_dump (lua_State* L, const Proto* f, lua_Writer w, void* data,
 #ifdef luac_c
 /* print one chunk; from print.c */
 LUAI_FUNC void luaU_print (const Proto* f, int full);
+
+/* write one chunk as C; from aot.c */
+LUAI_FUNC void luaU_aot (const Proto* f, const char* name, const char* chunk, size_t size, FILE* D);
 #endif
 
 /* for header of binary files -- this is Lua 5.1 */
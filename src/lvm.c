@@ -18,6 +18,7 @@
 #include "ldo.h"
 #include "lfunc.h"
 #include "lgc.h"
+#include "ljit.h"
 #include "lobject.h"
 #include "lopcodes.h"
 #include "lstate.h"
@@ -92,6 +93,162 @@ static void callTMres (lua_State *L, StkId res, const TValue *f,
 }
 
 
+/*
+** calls the fast version of the C function at `func' (see
+** `lua_setfastcfunction'), whose arguments go up to `L->top', without
+** a CallInfo: `L->base' and the top of the current frame are moved
+** around it. Leaves its result at `func' and returns 1, or returns 0
+** (with the stack as it was) when it declines.
+*/
+static int fastcall (lua_State *L, StkId func) {
+  CClosure *cl = &clvalue(func)->c;
+  StkId base = L->base;
+  StkId top = L->top;
+  StkId citop = L->ci->top;
+  int n;
+  L->base = func + 1;
+  L->ci->top = top + 1;  /* room for the result */
+  n = (*cl->fastf)(L);
+  lua_assert(n == 0 || (n == 1 && L->top == top + 1));
+  if (n) setobjs2s(L, func, L->top - 1);
+  L->base = base;
+  L->top = top;
+  L->ci->top = citop;
+  return n;
+}
+
+
+/*
+** computes the call of the builtin at `ra' (see `lua_setintrinsic') with
+** `nargs' arguments, when they are what that builtin takes, as the C
+** function would: leaves the result at `ra' and returns 1, or returns 0.
+** The builtin is known by the mark on its CClosure, so a function put in
+** its place (in `math' or anywhere) is never taken for it.
+*/
+static int intrinsic (StkId ra, int nargs) {
+  int kind = clvalue(ra)->c.intrinsic;
+  const TValue *x = ra + 1;
+  const TValue *y = ra + 2;
+  lua_Number a, b;
+  if (nargs != (kind < LUA_INTRFMOD ? 1 : 2)) return 0;
+  switch (kind) {
+    case LUA_INTRLEN: {
+      if (!ttisstring(x) || tsvalue(x)->len > cast(size_t, MAX_INT))
+        return 0;
+      setivalue(ra, cast_int(tsvalue(x)->len));
+      return 1;
+    }
+    case LUA_INTRBYTE: {
+      size_t l;
+      lua_Integer pos;
+      if (!ttisstring(x) || !ttisnumber(y)) return 0;
+      l = tsvalue(x)->len;
+      lua_number2integer(pos, nvalue(y));
+      if (pos < 0) pos += cast(lua_Integer, l) + 1;  /* like `posrelat' */
+      if (pos < 1 || cast(size_t, pos) > l) return 0;
+      setivalue(ra, cast(unsigned char, svalue(x)[pos-1]));
+      return 1;
+    }
+    default: break;
+  }
+  if (!ttisnumber(x)) return 0;
+  a = nvalue(x);
+  if (nargs == 2) {
+    if (!ttisnumber(y)) return 0;
+    b = nvalue(y);
+  }
+  else b = 0;
+  switch (kind) {
+    case LUA_INTRABS: a = fabs(a); break;
+    case LUA_INTRCEIL: a = ceil(a); break;
+    case LUA_INTRFLOOR: a = floor(a); break;
+    case LUA_INTRSQRT: a = sqrt(a); break;
+    case LUA_INTRSIN: a = sin(a); break;
+    case LUA_INTRCOS: a = cos(a); break;
+    case LUA_INTREXP: a = exp(a); break;
+    case LUA_INTRLOG: a = log(a); break;
+    case LUA_INTRFMOD: a = fmod(a, b); break;
+    case LUA_INTRMIN: if (b < a) a = b; break;
+    case LUA_INTRMAX: if (b > a) a = b; break;
+    default: return 0;
+  }
+  setnvalue(ra, a);
+  return 1;
+}
+
+
+/* the function at `o' is a C function `callfast' may do */
+#define isfastcall(o)	(ttisfunction(o) && clvalue(o)->c.isC && \
+                         (clvalue(o)->c.intrinsic != 0 || \
+                          clvalue(o)->c.fastf != NULL))
+
+
+/*
+** the call of OP_CALL to the function at `ra', known to pass `isfastcall',
+** with `nargs' arguments: computed by `intrinsic' or done by `fastcall',
+** unless hooks must see it. Returns 1 if done, and then leaves in `*ic'
+** (the inline cache of the call) how: the builtin or CALL_FASTC
+*/
+static int callfast (lua_State *L, StkId ra, int nargs, int nresults,
+                     int *ic) {
+  CClosure *f = &clvalue(ra)->c;
+  int how = f->intrinsic;
+  if (L->hookmask & (LUA_MASKCALL | LUA_MASKRET)) return 0;
+  if (how == 0 || !intrinsic(ra, nargs)) {
+    if (f->fastf == NULL || f->fastnargs != nargs || !fastcall(L, ra))
+      return 0;
+    how = CALL_FASTC;
+  }
+  *ic = how;
+  if (nresults >= 0) {
+    while (--nresults > 0) setnilvalue(ra + nresults);
+    L->top = L->ci->top;
+  }
+  else L->top = ra + 1;
+  return 1;
+}
+
+
+/*
+** OP_TFORLOOP A C over a table with a builtin iterator (see
+** `lua_setiterator'), doing its step instead of calling it unless hooks
+** must see the call. Returns 1 if the loop goes on (with the C loop
+** variables and the control variable set), 0 if it ends, or -1 when
+** the iterator must be called: then also when `next' would have to
+** search for the control key, which may be invalid, so that the error
+** comes from `next' as it always did.
+*/
+static int tforloop (lua_State *L, StkId ra, int nvars) {
+  StkId cb = ra + 3;  /* where the call would leave its results */
+  Table *h;
+  if (!ttisfunction(ra) || !clvalue(ra)->c.isC || clvalue(ra)->c.iter == 0 ||
+      !ttistable(ra + 1) || (L->hookmask & (LUA_MASKCALL | LUA_MASKRET)))
+    return -1;
+  h = hvalue(ra + 1);
+  if (clvalue(ra)->c.iter == LUA_ITERNEXT) {
+    int go;
+    setobjs2s(L, cb, ra + 2);
+    go = luaH_nextknown(L, h, cb);
+    if (go <= 0)
+      return go;  /* end, or `next' must search the key (and raise errors) */
+  }
+  else {
+    const TValue *v;
+    int n;
+    if (!ttisint(ra + 2)) return -1;
+    n = ivalue(ra + 2) + 1;
+    v = luaH_getnum(h, n);
+    if (ttisnil(v))
+      return 0;
+    setobj2s(L, cb + 1, v);
+    setivalue(cb, n);
+  }
+  while (nvars > 2) setnilvalue(cb + --nvars);
+  setobjs2s(L, ra + 2, cb);  /* save control variable */
+  return 1;
+}
+
+
 // 调用某函数,但是没有结果,这与callTMres不同
 static void callTM (lua_State *L, const TValue *f, const TValue *p1,
                     const TValue *p2, const TValue *p3) {
@@ -143,8 +300,15 @@ void luaV_settable (lua_State *L, const TValue *t, TValue *key, StkId val) {
     if (ttistable(t)) {  /* `t' is a table? */
       // 如果t是一个表, 首先获取它的hash部分
       Table *h = hvalue(t);
-      //
-      TValue *oldval = luaH_set(L, h, key); /* do a primitive set */
+      TValue *oldval;
+#if defined(LUA_PACKARRAY)
+      if (ttisint(key) && ttisnumber(val) &&
+          fasttm(L, h->metatable, TM_NEWINDEX) == NULL) {
+        luaH_setint(L, h, ivalue(key), val);  /* may keep `h' packed */
+        return;
+      }
+#endif
+      oldval = luaH_set(L, h, key); /* do a primitive set */
       if (!ttisnil(oldval) ||  /* result is no nil? */
           (tm = fasttm(L, h->metatable, TM_NEWINDEX)) == NULL) { /* or no TM? */
     	// 替换原来的旧值
@@ -166,6 +330,86 @@ void luaV_settable (lua_State *L, const TValue *t, TValue *key, StkId val) {
 }
 
 
+/*
+** val := t[key] for OP_SELF and a string `key' that `t' (if a table)
+** lacks itself. The answer then depends only on the metatable of `t'
+** and on the tables along its `__index' chain, so it goes into the
+** method cache under (metatable, key) and later calls get it with one
+** probe however deep the chain. Those tables are marked `watched':
+** a write to any of them (see `luaV_touch'), like each collection,
+** moves the cache to a new version. Chains that reach an `__index'
+** function are not cached.
+*/
+void luaV_getmethod (lua_State *L, const TValue *t, TValue *key, StkId val) {
+  global_State *g = G(L);
+  TString *ts = rawtsvalue(key);
+  const TValue *o = t;  /* object whose `__index' is `tm' */
+  const TValue *tm;
+  Table *mt;
+  MCEntry *e;
+  int loop;
+  switch (ttype(t)) {
+    case LUA_TTABLE: mt = hvalue(t)->metatable; break;
+    case LUA_TUSERDATA: mt = uvalue(t)->metatable; break;
+    default: mt = g->mt[ttype(t)];
+  }
+  if (mt == NULL || (tm = fasttm(L, mt, TM_INDEX)) == NULL) {
+    luaV_gettable(L, t, key, val);  /* no chain to follow */
+    return;
+  }
+  e = mcentry(g, mt, ts);
+  if (mcvalid(g, e, mt, ts)) {
+    setobj2s(L, val, &e->value);
+    return;
+  }
+  mt->watched = 1;
+  for (loop = 0; loop < MAXTAGLOOP; loop++) {
+    Table *h;
+    const TValue *res;
+    if (!ttistable(tm)) {
+      if (ttisfunction(tm))
+        callTMres(L, val, tm, o, key);
+      else
+        luaV_gettable(L, tm, key, val);
+      return;
+    }
+    h = hvalue(tm);
+    h->watched = 1;
+    if (h->metatable)
+      h->metatable->watched = 1;
+    res = luaH_getstr(h, ts);
+    if (!ttisnil(res) || fasttm(L, h->metatable, TM_INDEX) == NULL) {
+      e->mt = mt;
+      e->key = ts;
+      setobj(L, &e->value, res);
+      e->version = g->mcversion;
+      setobj2s(L, val, res);
+      return;
+    }
+    o = tm;
+    tm = fasttm(L, h->metatable, TM_INDEX);
+  }
+  luaG_runerror(L, "loop in gettable");
+}
+
+
+void luaV_newversion (global_State *g) {
+  if (++g->mcversion == 0) {  /* wrapped around? */
+    int i;
+    for (i = 0; i < MCACHESIZE; i++) g->mcache[i].version = 0;
+    g->mcversion = 1;
+  }
+}
+
+
+/* a write to a `watched' table: it may be frozen, or cached */
+void luaV_touched (lua_State *L, Table *t) {
+  if (t->frozen)
+    luaG_runerror(L, "attempt to modify a frozen table");
+  luaV_newversion(G(L));
+}
+
+
 static int call_binTM (lua_State *L, const TValue *p1, const TValue *p2,
                        StkId res, TMS event) {
   const TValue *tm = luaT_gettmbyobj(L, p1, event);  /* try first operand */
@@ -228,7 +472,9 @@ static int l_strcmp (const TString *ls, const TString *rs) {
 
 int luaV_lessthan (lua_State *L, const TValue *l, const TValue *r) {
   int res;
-  if (ttype(l) != ttype(r))
+  if (ttisint(l) && ttisint(r))
+    return ivalue(l) < ivalue(r);
+  else if (ttype(l) != ttype(r))
     return luaG_ordererror(L, l, r);
   else if (ttisnumber(l))
     return luai_numlt(nvalue(l), nvalue(r));
@@ -240,9 +486,11 @@ int luaV_lessthan (lua_State *L, const TValue *l, const TValue *r) {
 }
 
 
-static int lessequal (lua_State *L, const TValue *l, const TValue *r) {
+int luaV_lessequal (lua_State *L, const TValue *l, const TValue *r) {
   int res;
-  if (ttype(l) != ttype(r))
+  if (ttisint(l) && ttisint(r))
+    return ivalue(l) <= ivalue(r);
+  else if (ttype(l) != ttype(r))
     return luaG_ordererror(L, l, r);
   else if (ttisnumber(l))
     return luai_numle(nvalue(l), nvalue(r));
@@ -341,12 +589,79 @@ static void Arith (lua_State *L, StkId ra, const TValue *rb,
 }
 
 
+/* `intmul' (see lvm.h) out of line, for operands it does not take inline */
+int luaV_intmul (int a, int b, int *r) {
+  lua_Number n;
+#if LUAI_BITSINT >= 32
+  if (-46340 <= a && a <= 46340 && -46340 <= b && b <= 46340) {
+    *r = a * b;  /* cannot overflow */
+    return (*r != 0 || (a >= 0 && b >= 0));  /* fail for -0 */
+  }
+#endif
+  n = luai_nummul(cast_num(a), cast_num(b));
+  if (n < cast_num(INT_MIN) || n > cast_num(INT_MAX) ||
+      (n == 0 && (a < 0 || b < 0)))  /* out of range or -0? */
+    return 0;
+  *r = cast_int(n);
+  return 1;
+}
+
+
+/*
+** whole semantics of an arithmetic opcode (integer subtype, numbers
+** and metamethods), for callers outside `luaV_execute'
+*/
+void luaV_arith (lua_State *L, StkId ra, const TValue *rb,
+                 const TValue *rc, TMS op) {
+  if (ttisint(rb) && ttisint(rc)) {
+    int b = ivalue(rb), c = ivalue(rc);
+    int ir, done;
+    switch (op) {
+      case TM_ADD: done = intadd(b, c, ir); break;
+      case TM_SUB: done = intsub(b, c, ir); break;
+      case TM_MUL: done = intmul(b, c, ir); break;
+      case TM_MOD: done = intmod(b, c, ir); break;
+      case TM_UNM: done = (b != 0 && b != INT_MIN && (ir = -b, 1)); break;
+      default: done = 0; break;
+    }
+    if (done) {
+      setivalue(ra, ir);
+      return;
+    }
+  }
+  Arith(L, ra, rb, rc, op);
+}
+
+
+void luaV_objlen (lua_State *L, StkId ra, const TValue *rb) {
+  switch (ttype(rb)) {
+    case LUA_TTABLE: {
+      setivalue(ra, luaH_getn(hvalue(rb)));
+      break;
+    }
+    case LUA_TSTRING: {
+      size_t len = tsvalue(rb)->len;
+      if (len <= cast(size_t, INT_MAX)) {
+        setivalue(ra, cast_int(len));
+      }
+      else {
+        setnvalue(ra, cast_num(len));
+      }
+      break;
+    }
+    default: {  /* try metamethod */
+      if (!call_binTM(L, rb, luaO_nilobject, ra, TM_LEN))
+        luaG_typeerror(L, rb, "get length of");
+    }
+  }
+}
+
 
 /*
 ** some macros for common tasks in `luaV_execute'
 */
 
-#define runtime_check(L, c)	{ if (!(c)) break; }
+#define runtime_check(L, c)	{ if (!(c)) vmbreak; }
 
 #define RA(i)	(base+GETARG_A(i))
 /* to be used after possible stack reallocation */
@@ -357,18 +672,262 @@ static void Arith (lua_State *L, StkId ra, const TValue *rb,
 #define RKC(i)	check_exp(getCMode(GET_OPCODE(i)) == OpArgK, \
 	ISK(GETARG_C(i)) ? k+INDEXK(GETARG_C(i)) : base+GETARG_C(i))
 #define KBx(i)	check_exp(getBMode(GET_OPCODE(i)) == OpArgK, k+GETARG_Bx(i))
+#define KC(i)	check_exp(getCMode(GET_OPCODE(i)) == OpArgK && ISK(GETARG_C(i)), \
+	k+INDEXK(GETARG_C(i)))
 
 
-#define dojump(L,pc,i)	{(pc) += (i); luai_threadyield(L);}
+/* inline cache of the current instruction (see `luaF_newicache') */
+#define ICACHE()	(&cl->p->icache[pcRel(pc, cl->p)])
 
 
-#define Protect(x)	{ L->savedpc = pc; {x;}; base = L->base; }
+/* rewrites the current instruction to opcode `o' (see LUAI_QUICKEN) */
+#if defined(LUAI_QUICKEN)
+#define quicken(o)	SET_OPCODE(*cast(Instruction *, pc - 1), o)
+#else
+#define quicken(o)	((void)0)
+#endif
 
 
-#define arith_op(op,tm) { \
+/*
+** R(A) := t[key] for a table `t' and a string `key', through the inline
+** cache; the general path is taken only for metamethods
+*/
+#define gettablestr(t,key) { \
+        Table *h = hvalue(t); \
+        const TValue *res = luaH_getstrfast(h, rawtsvalue(key), ICACHE()); \
+        if (!ttisnil(res) || fasttm(L, h->metatable, TM_INDEX) == NULL) { \
+          setobj2s(L, ra, res); \
+        } \
+        else \
+          Protect(luaV_gettable(L, t, key, ra)); \
+      }
+
+
+/*
+** R(A) := t[key] for OP_SELF, a table `t' and a string `key': `t' itself
+** through the inline cache, then its metatable through the method cache
+*/
+#define selfstr(t,key) { \
+        Table *h = hvalue(t); \
+        const TValue *res = luaH_getstrfast(h, rawtsvalue(key), ICACHE()); \
+        MCEntry *e; \
+        if (!ttisnil(res) || h->metatable == NULL) { \
+          setobj2s(L, ra, res); \
+        } \
+        else if (e = mcentry(G(L), h->metatable, rawtsvalue(key)), \
+                 mcvalid(G(L), e, h->metatable, rawtsvalue(key))) { \
+          setobj2s(L, ra, &e->value); \
+        } \
+        else \
+          Protect(luaV_getmethod(L, t, key, ra)); \
+      }
+
+
+/*
+** t[key] := val for a table `t' and a string `key' already present in
+** it (so neither `__newindex' nor a new key is involved); otherwise,
+** or when `t' is `watched' (see `luaV_touch'), falls to the general path
+*/
+#define settablestr(t,key,val) { \
+        Table *h = hvalue(t); \
+        TValue *slot = cast(TValue *, \
+                            luaH_getstrfast(h, rawtsvalue(key), ICACHE())); \
+        if (!ttisnil(slot) && !h->watched) { \
+          setobj2t(L, slot, val); \
+          luaC_barriert(L, h, val); \
+        } \
+        else \
+          Protect(luaV_settable(L, t, key, val)); \
+      }
+
+
+#if defined(LUA_PACKARRAY)
+/*
+** R(A) := h[n] and h[n] := val for `n' inside a packed array part (see
+** ltable.c); they return 0 when the generic path must do it
+*/
+static int packedget (lua_State *L, Table *h, int n, TValue *ra) {
+  PackedNum *p;
+  if (cast(unsigned int, n-1) >= cast(unsigned int, h->sizenarray))
+    return 0;
+  p = &h->narray[n-1];
+  if (!packedisnil(p)) {
+    setnvalue(ra, p->n);
+  }
+  else if (fasttm(L, h->metatable, TM_INDEX) == NULL) {
+    setnilvalue(ra);
+  }
+  else return 0;
+  return 1;
+}
+
+
+static int packedset (lua_State *L, Table *h, int n, const TValue *val) {
+  if (cast(unsigned int, n-1) >= cast(unsigned int, h->sizenarray) ||
+      !(ttisnumber(val) || ttisnil(val)) || h->watched ||
+      (packedisnil(&h->narray[n-1]) &&
+       fasttm(L, h->metatable, TM_NEWINDEX) != NULL))
+    return 0;
+  if (ttisnil(val)) setpackednil(&h->narray[n-1]);
+  else setpacked(&h->narray[n-1], nvalue(val));
+  return 1;
+}
+#else
+#define packedget(L,h,n,ra)	0
+#define packedset(L,h,n,val)	0
+#endif
+
+
+/*
+** R(A) := t[key] and t[key] := val for an integer `key' inside the array
+** part of `t'; nil slots are handled here only when no metamethod can
+** be involved, and stores only when `t' is not `watched'
+*/
+#define gettableint(t,key) { \
+        Table *h = hvalue(t); \
+        int n = ivalue(key); \
+        const TValue *res; \
+        if (cast(unsigned int, n-1) < cast(unsigned int, h->sizearray) && \
+            (!ttisnil(res = &h->array[n-1]) || \
+             fasttm(L, h->metatable, TM_INDEX) == NULL)) { \
+          setobj2s(L, ra, res); \
+        } \
+        else if (!packedget(L, h, n, ra)) \
+          Protect(luaV_gettable(L, t, key, ra)); \
+      }
+
+#define settableint(t,key,val) { \
+        Table *h = hvalue(t); \
+        int n = ivalue(key); \
+        TValue *slot; \
+        if (cast(unsigned int, n-1) < cast(unsigned int, h->sizearray) && \
+            !h->watched && \
+            (!ttisnil(slot = &h->array[n-1]) || \
+             fasttm(L, h->metatable, TM_NEWINDEX) == NULL)) { \
+          setobj2t(L, slot, val); \
+          luaC_barriert(L, h, val); \
+        } \
+        else if (!packedset(L, h, n, val)) \
+          Protect(luaV_settable(L, t, key, val)); \
+      }
+
+
+#define dojump(L,pc,i)	{(pc) += (i); luai_threadyield(L); vmhookcheck();}
+
+
+#define Protect(x)	{ L->savedpc = pc; {x;}; base = L->base; vmhookcheck(); }
+
+
+/*
+** on entry (and return) to a function, after calls to C functions and on
+** backward jumps, a function with native code runs it from `pc' until
+** that code hands control back to the interpreter. Native code is either
+** C generated by `luac -c' (see laot.h) or, for functions with hot loops,
+** machine code (see ljit.c); neither runs while line or count hooks are
+** on. Machine code gives calls and returns back to the interpreter, so
+** it is entered (and counted towards LUAI_JITHOT) only on backward jumps
+** (`vmloop'), not to go back to it for a few instructions after each call.
+*/
+#define vmenter(x)	{ \
+  const Instruction *npc = (x); \
+  if (npc != pc) { pc = npc; base = L->base; vmhookcheck(); } }
+
+#define vmaot()	(cl->p->aot != NULL && \
+                 !(L->hookmask & (LUA_MASKLINE | LUA_MASKCOUNT)))
+
+#define vmnative()	{ if (vmaot()) vmenter((*cl->p->aot)(L, pc)) }
+
+#if defined(LUA_USE_JIT)
+#define vmloop()	{ \
+  if (vmaot()) vmenter((*cl->p->aot)(L, pc)) \
+  else if (cl->p->jit != NULL || --cl->p->jithot == 0) \
+    vmenter(luaJ_enter(L, cl->p, pc)) }
+#else
+#define vmloop()	vmnative()
+#endif
+
+
+/*
+** line/count hooks for the instruction in `i' (`pc' already points past
+** it); only reached while `hooked' (or `hooktab') says hooks may be on
+*/
+#define vmtrace()	{ \
+  if ((L->hookmask & (LUA_MASKLINE | LUA_MASKCOUNT)) && \
+      (--L->hookcount == 0 || L->hookmask & LUA_MASKLINE)) { \
+    traceexec(L, pc); \
+    if (L->status == LUA_YIELD) {  /* did hook yield? */ \
+      L->savedpc = pc - 1; \
+      return; \
+    } \
+    base = L->base; \
+  } \
+  vmhookcheck(); \
+}
+
+
+/*
+** re-read the hook mask; done on (re)entry, after anything that may run
+** arbitrary code (calls, metamethods) and on jumps, so that hooks set
+** from a signal handler are also seen inside loops
+*/
+#define vmhookcheck()	(hooked = L->hookmask & (LUA_MASKLINE | LUA_MASKCOUNT))
+
+
+/* fetch the next instruction into `i' */
+#define vmfetch()	{ \
+  i = *pc++; \
+  if (hooked) vmtrace(); \
+  /* warning!! several calls may realloc the stack and invalidate `ra' */ \
+  ra = RA(i); \
+  lua_assert(base == L->base && L->base == L->ci->base); \
+  lua_assert(base <= L->top && L->top <= L->stack + L->stacksize); \
+  lua_assert(L->top == L->ci->top || luaG_checkopenop(i)); \
+}
+
+
+/*
+** instruction dispatch; `ljumptab.h' redefines these to jump straight
+** from one instruction to the next when LUAI_JUMPTABLE is on
+*/
+#define vmdispatch(o)	switch(o)
+#define vmcase(l)	case l:
+#define vmbreak		continue
+
+
+#define arithk_op(op,iop,tm,fq) { \
+        TValue *rb = RB(i); \
+        TValue *rc = KC(i); \
+        int ir; \
+        if (ttisint(rb) && ttisint(rc) && iop(ivalue(rb), ivalue(rc), ir)) { \
+          setivalue(ra, ir); \
+        } \
+        else if (ttisfloat(rb) && ttisfloat(rc)) { \
+          lua_Number nb = fltvalue(rb), nc = fltvalue(rc); \
+          setnvalue(ra, op(nb, nc)); \
+          fq; \
+        } \
+        else if (ttisnumber(rb)) { \
+          lua_Number nb = nvalue(rb), nc = nvalue(rc); \
+          setnvalue(ra, op(nb, nc)); \
+        } \
+        else \
+          Protect(Arith(L, ra, rb, rc, tm)); \
+      }
+
+
+#define arith_op(op,iop,tm,fq) { \
         TValue *rb = RKB(i); \
         TValue *rc = RKC(i); \
-        if (ttisnumber(rb) && ttisnumber(rc)) { \
+        int ir; \
+        if (ttisint(rb) && ttisint(rc) && iop(ivalue(rb), ivalue(rc), ir)) { \
+          setivalue(ra, ir); \
+        } \
+        else if (ttisfloat(rb) && ttisfloat(rc)) { \
+          lua_Number nb = fltvalue(rb), nc = fltvalue(rc); \
+          setnvalue(ra, op(nb, nc)); \
+          fq; \
+        } \
+        else if (ttisnumber(rb) && ttisnumber(rc)) { \
           lua_Number nb = nvalue(rb), nc = nvalue(rc); \
           setnvalue(ra, op(nb, nc)); \
         } \
@@ -378,175 +937,214 @@ static void Arith (lua_State *L, StkId ra, const TValue *rb,
 
 
 
+/*
+** quickened float forms of `arith_op' and `arithk_op'; a miss turns the
+** instruction back into its generic opcode `gop' and runs that instead
+*/
+#define farith_op(op,iop,tm,gop) { \
+        TValue *fb = RKB(i); \
+        TValue *fc = RKC(i); \
+        if (ttisfloat(fb) && ttisfloat(fc)) { \
+          lua_Number nb = fltvalue(fb), nc = fltvalue(fc); \
+          setnvalue(ra, op(nb, nc)); \
+        } \
+        else { \
+          quicken(gop); \
+          arith_op(op, iop, tm, (void)0); \
+        } \
+      }
+
+
+#define farithk_op(op,iop,tm,gop) { \
+        TValue *fb = RB(i); \
+        TValue *fc = KC(i); \
+        if (ttisfloat(fb) && ttisfloat(fc)) { \
+          lua_Number nb = fltvalue(fb), nc = fltvalue(fc); \
+          setnvalue(ra, op(nb, nc)); \
+        } \
+        else { \
+          quicken(gop); \
+          arithk_op(op, iop, tm, (void)0); \
+        } \
+      }
+
+
+
 void luaV_execute (lua_State *L, int nexeccalls) {
   LClosure *cl;
   StkId base;
   TValue *k;
   const Instruction *pc;
+  Instruction i;
+  StkId ra;
+#if defined(LUAI_JUMPTABLE)
+#include "ljumptab.h"
+#else
+  int hooked;
+#endif
  reentry:  /* entry point */
   lua_assert(isLua(L->ci));
   pc = L->savedpc;
   cl = &clvalue(L->ci->func)->l;
   base = L->base;
   k = cl->p->k;
+  vmhookcheck();
+  vmnative();
   /* main loop of interpreter */
   for (;;) {
-    const Instruction i = *pc++;
-    StkId ra;
-    if ((L->hookmask & (LUA_MASKLINE | LUA_MASKCOUNT)) &&
-        (--L->hookcount == 0 || L->hookmask & LUA_MASKLINE)) {
-      traceexec(L, pc);
-      if (L->status == LUA_YIELD) {  /* did hook yield? */
-        L->savedpc = pc - 1;
-        return;
-      }
-      base = L->base;
-    }
-    /* warning!! several calls may realloc the stack and invalidate `ra' */
-    ra = RA(i);
-    lua_assert(base == L->base && L->base == L->ci->base);
-    lua_assert(base <= L->top && L->top <= L->stack + L->stacksize);
-    lua_assert(L->top == L->ci->top || luaG_checkopenop(i));
-    switch (GET_OPCODE(i)) {
-      case OP_MOVE: {
+    vmfetch();
+    vmdispatch (GET_OPCODE(i)) {
+      vmcase(OP_MOVE) {
         setobjs2s(L, ra, RB(i));
-        continue;
+        vmbreak;
       }
-      case OP_LOADK: {
+      vmcase(OP_LOADK) {
         setobj2s(L, ra, KBx(i));
-        continue;
+        vmbreak;
       }
-      case OP_LOADBOOL: {
+      vmcase(OP_LOADBOOL) {
         setbvalue(ra, GETARG_B(i));
         if (GETARG_C(i)) pc++;  /* skip next instruction (if C) */
-        continue;
+        vmbreak;
       }
-      case OP_LOADNIL: {
+      vmcase(OP_LOADNIL) {
         TValue *rb = RB(i);
         do {
           setnilvalue(rb--);
         } while (rb >= ra);
-        continue;
+        vmbreak;
       }
-      case OP_GETUPVAL: {
+      vmcase(OP_GETUPVAL) {
         int b = GETARG_B(i);
         setobj2s(L, ra, cl->upvals[b]->v);
-        continue;
+        vmbreak;
       }
-      case OP_GETGLOBAL: {
+      vmcase(OP_GETGLOBAL) {
         TValue g;
         TValue *rb = KBx(i);
         sethvalue(L, &g, cl->env);
         lua_assert(ttisstring(rb));
-        Protect(luaV_gettable(L, &g, rb, ra));
-        continue;
+        gettablestr(&g, rb);
+        vmbreak;
       }
-      case OP_GETTABLE: {
-        Protect(luaV_gettable(L, RB(i), RKC(i), ra));
-        continue;
+      vmcase(OP_GETTABLE) {
+        TValue *rb = RB(i);
+        TValue *rc = RKC(i);
+        if (ttistable(rb) && ttisstring(rc))
+          gettablestr(rb, rc)
+        else if (ttistable(rb) && ttisint(rc)) {
+          quicken(OP_GETTABLEI);
+          gettableint(rb, rc)
+        }
+        else
+          Protect(luaV_gettable(L, rb, rc, ra));
+        vmbreak;
       }
-      case OP_SETGLOBAL: {
+      vmcase(OP_SETGLOBAL) {
         TValue g;
         sethvalue(L, &g, cl->env);
         lua_assert(ttisstring(KBx(i)));
-        Protect(luaV_settable(L, &g, KBx(i), ra));
-        continue;
+        settablestr(&g, KBx(i), ra);
+        vmbreak;
       }
-      case OP_SETUPVAL: {
+      vmcase(OP_SETUPVAL) {
         UpVal *uv = cl->upvals[GETARG_B(i)];
         setobj(L, uv->v, ra);
         luaC_barrier(L, uv, ra);
-        continue;
+        vmbreak;
       }
-      case OP_SETTABLE: {
-        Protect(luaV_settable(L, ra, RKB(i), RKC(i)));
-        continue;
+      vmcase(OP_SETTABLE) {
+        TValue *rb = RKB(i);
+        TValue *rc = RKC(i);
+        if (ttistable(ra) && ttisstring(rb))
+          settablestr(ra, rb, rc)
+        else if (ttistable(ra) && ttisint(rb)) {
+          quicken(OP_SETTABLEI);
+          settableint(ra, rb, rc)
+        }
+        else
+          Protect(luaV_settable(L, ra, rb, rc));
+        vmbreak;
       }
-      case OP_NEWTABLE: {
+      vmcase(OP_NEWTABLE) {
         int b = GETARG_B(i);
         int c = GETARG_C(i);
         sethvalue(L, ra, luaH_new(L, luaO_fb2int(b), luaO_fb2int(c)));
         Protect(luaC_checkGC(L));
-        continue;
+        vmbreak;
       }
-      case OP_SELF: {
+      vmcase(OP_SELF) {
         StkId rb = RB(i);
+        TValue *rc = RKC(i);
         setobjs2s(L, ra+1, rb);
-        Protect(luaV_gettable(L, rb, RKC(i), ra));
-        continue;
+        if (!ttisstring(rc))
+          Protect(luaV_gettable(L, rb, rc, ra))
+        else if (ttistable(rb))
+          selfstr(rb, rc)
+        else
+          Protect(luaV_getmethod(L, rb, rc, ra));
+        vmbreak;
       }
-      case OP_ADD: {
-        arith_op(luai_numadd, TM_ADD);
-        continue;
+      vmcase(OP_ADD) {
+        arith_op(luai_numadd, intadd, TM_ADD, quicken(OP_ADDF));
+        vmbreak;
       }
-      case OP_SUB: {
-        arith_op(luai_numsub, TM_SUB);
-        continue;
+      vmcase(OP_SUB) {
+        arith_op(luai_numsub, intsub, TM_SUB, quicken(OP_SUBF));
+        vmbreak;
       }
-      case OP_MUL: {
-        arith_op(luai_nummul, TM_MUL);
-        continue;
+      vmcase(OP_MUL) {
+        arith_op(luai_nummul, intmul, TM_MUL, quicken(OP_MULF));
+        vmbreak;
       }
-      case OP_DIV: {
-        arith_op(luai_numdiv, TM_DIV);
-        continue;
+      vmcase(OP_DIV) {
+        arith_op(luai_numdiv, intnone, TM_DIV, (void)0);
+        vmbreak;
       }
-      case OP_MOD: {
-        arith_op(luai_nummod, TM_MOD);
-        continue;
+      vmcase(OP_MOD) {
+        arith_op(luai_nummod, intmod, TM_MOD, (void)0);
+        vmbreak;
       }
-      case OP_POW: {
-        arith_op(luai_numpow, TM_POW);
-        continue;
+      vmcase(OP_POW) {
+        arith_op(luai_numpow, intnone, TM_POW, (void)0);
+        vmbreak;
       }
-      case OP_UNM: {
+      vmcase(OP_UNM) {
         TValue *rb = RB(i);
-        if (ttisnumber(rb)) {
+        if (ttisint(rb) && ivalue(rb) != 0 && ivalue(rb) != INT_MIN) {
+          setivalue(ra, -ivalue(rb));  /* (-0 and -INT_MIN are not ints) */
+        }
+        else if (ttisnumber(rb)) {
           lua_Number nb = nvalue(rb);
           setnvalue(ra, luai_numunm(nb));
         }
         else {
           Protect(Arith(L, ra, rb, rb, TM_UNM));
         }
-        continue;
+        vmbreak;
       }
-      case OP_NOT: {
+      vmcase(OP_NOT) {
         int res = l_isfalse(RB(i));  /* next assignment may change this value */
         setbvalue(ra, res);
-        continue;
-      }
-      case OP_LEN: {
-        const TValue *rb = RB(i);
-        switch (ttype(rb)) {
-          case LUA_TTABLE: {
-            setnvalue(ra, cast_num(luaH_getn(hvalue(rb))));
-            break;
-          }
-          case LUA_TSTRING: {
-            setnvalue(ra, cast_num(tsvalue(rb)->len));
-            break;
-          }
-          default: {  /* try metamethod */
-            Protect(
-              if (!call_binTM(L, rb, luaO_nilobject, ra, TM_LEN))
-                luaG_typeerror(L, rb, "get length of");
-            )
-          }
-        }
-        continue;
+        vmbreak;
+      }
+      vmcase(OP_LEN) {
+        Protect(luaV_objlen(L, ra, RB(i)));
+        vmbreak;
       }
-      case OP_CONCAT: {
+      vmcase(OP_CONCAT) {
         int b = GETARG_B(i);
         int c = GETARG_C(i);
         Protect(luaV_concat(L, c-b+1, c); luaC_checkGC(L));
         setobjs2s(L, RA(i), base+b);
-        continue;
+        vmbreak;
       }
-      case OP_JMP: {
+      vmcase(OP_JMP) {
         dojump(L, pc, GETARG_sBx(i));
-        continue;
+        if (GETARG_sBx(i) < 0) vmloop();
+        vmbreak;
       }
-      case OP_EQ: {
+      vmcase(OP_EQ) {
         TValue *rb = RKB(i);
         TValue *rc = RKC(i);
         Protect(
@@ -554,46 +1152,65 @@ void luaV_execute (lua_State *L, int nexeccalls) {
             dojump(L, pc, GETARG_sBx(*pc));
         )
         pc++;
-        continue;
+        vmbreak;
       }
-      case OP_LT: {
-        Protect(
-          if (luaV_lessthan(L, RKB(i), RKC(i)) == GETARG_A(i))
+      vmcase(OP_LT) {
+        TValue *rb = RKB(i);
+        TValue *rc = RKC(i);
+        if (ttisint(rb) && ttisint(rc)) {
+          if ((ivalue(rb) < ivalue(rc)) == GETARG_A(i))
             dojump(L, pc, GETARG_sBx(*pc));
-        )
+        }
+        else
+          Protect(
+            if (luaV_lessthan(L, rb, rc) == GETARG_A(i))
+              dojump(L, pc, GETARG_sBx(*pc));
+          )
         pc++;
-        continue;
+        vmbreak;
       }
-      case OP_LE: {
-        Protect(
-          if (lessequal(L, RKB(i), RKC(i)) == GETARG_A(i))
+      vmcase(OP_LE) {
+        TValue *rb = RKB(i);
+        TValue *rc = RKC(i);
+        if (ttisint(rb) && ttisint(rc)) {
+          if ((ivalue(rb) <= ivalue(rc)) == GETARG_A(i))
             dojump(L, pc, GETARG_sBx(*pc));
-        )
+        }
+        else
+          Protect(
+            if (luaV_lessequal(L, rb, rc) == GETARG_A(i))
+              dojump(L, pc, GETARG_sBx(*pc));
+          )
         pc++;
-        continue;
+        vmbreak;
       }
-      case OP_TEST: {
+      vmcase(OP_TEST) {
         if (l_isfalse(ra) != GETARG_C(i))
           dojump(L, pc, GETARG_sBx(*pc));
         pc++;
-        continue;
+        vmbreak;
       }
-      case OP_TESTSET: {
+      vmcase(OP_TESTSET) {
         TValue *rb = RB(i);
         if (l_isfalse(rb) != GETARG_C(i)) {
           setobjs2s(L, ra, rb);
           dojump(L, pc, GETARG_sBx(*pc));
         }
         pc++;
-        continue;
+        vmbreak;
       }
-      case OP_CALL: {
+      vmcase(OP_CALL) {
         int b = GETARG_B(i);
         int nresults = GETARG_C(i) - 1;
         // 如果传入参数数量不为0, 则这是top地址,由它开始后面紧跟着都是函数参数
         if (b != 0) L->top = ra+b;  /* else previous instruction set top */
         // 保存当前pc
         L->savedpc = pc;
+        if (b != 0 && isfastcall(ra) &&
+            callfast(L, ra, b - 1, nresults, ICACHE())) {
+          vmnative();
+          vmbreak;
+        }
         switch (luaD_precall(L, ra, nresults)) {
           case PCRLUA: {
             nexeccalls++;
@@ -603,14 +1220,16 @@ void luaV_execute (lua_State *L, int nexeccalls) {
             /* it was a C function (`precall' called it); adjust results */
             if (nresults >= 0) L->top = L->ci->top;
             base = L->base;
-            continue;
+            vmhookcheck();
+            vmnative();
+            vmbreak;
           }
           default: {
             return;  /* yield */
           }
         }
       }
-      case OP_TAILCALL: {
+      vmcase(OP_TAILCALL) {
         int b = GETARG_B(i);
         if (b != 0) L->top = ra+b;  /* else previous instruction set top */
         L->savedpc = pc;
@@ -635,14 +1254,15 @@ void luaV_execute (lua_State *L, int nexeccalls) {
           }
           case PCRC: {  /* it was a C function (`precall' called it) */
             base = L->base;
-            continue;
+            vmhookcheck();
+            vmbreak;
           }
           default: {
             return;  /* yield */
           }
         }
       }
-      case OP_RETURN: {
+      vmcase(OP_RETURN) {
         int b = GETARG_B(i);
         if (b != 0) L->top = ra+b-1;
         if (L->openupval) luaF_close(L, base);
@@ -657,35 +1277,71 @@ void luaV_execute (lua_State *L, int nexeccalls) {
           goto reentry;
         }
       }
-      case OP_FORLOOP: {
-        lua_Number step = nvalue(ra+2);
-        lua_Number idx = luai_numadd(nvalue(ra), step); /* increment index */
-        lua_Number limit = nvalue(ra+1);
-        if (luai_numlt(0, step) ? luai_numle(idx, limit)
-                                : luai_numle(limit, idx)) {
-          dojump(L, pc, GETARG_sBx(i));  /* jump back */
-          setnvalue(ra, idx);  /* update internal index... */
-          setnvalue(ra+3, idx);  /* ...and external index */
+      vmcase(OP_FORLOOP) {
+        if (ttisint(ra)) {  /* integer loop? */
+          int step = ivalue(ra+2);
+          int idx;
+          /* an overflow can only mean that the index went past the limit */
+          if (intadd(ivalue(ra), step, idx) &&
+              (0 < step ? idx <= ivalue(ra+1) : ivalue(ra+1) <= idx)) {
+            dojump(L, pc, GETARG_sBx(i));  /* jump back */
+            setivalue(ra, idx);  /* update internal index... */
+            setivalue(ra+3, idx);  /* ...and external index */
+            vmloop();
+          }
         }
-        continue;
+        else {
+          lua_Number step = fltvalue(ra+2);
+          lua_Number idx = luai_numadd(fltvalue(ra), step); /* increment index */
+          lua_Number limit = fltvalue(ra+1);
+          if (luai_numlt(0, step) ? luai_numle(idx, limit)
+                                  : luai_numle(limit, idx)) {
+            dojump(L, pc, GETARG_sBx(i));  /* jump back */
+            setnvalue(ra, idx);  /* update internal index... */
+            setnvalue(ra+3, idx);  /* ...and external index */
+            vmloop();
+          }
+        }
+        vmbreak;
       }
-      case OP_FORPREP: {
+      vmcase(OP_FORPREP) {
         const TValue *init = ra;
         const TValue *plimit = ra+1;
         const TValue *pstep = ra+2;
+        int ir;
         L->savedpc = pc;  /* next steps may throw errors */
-        if (!tonumber(init, ra))
-          luaG_runerror(L, LUA_QL("for") " initial value must be a number");
-        else if (!tonumber(plimit, ra+1))
-          luaG_runerror(L, LUA_QL("for") " limit must be a number");
-        else if (!tonumber(pstep, ra+2))
-          luaG_runerror(L, LUA_QL("for") " step must be a number");
-        setnvalue(ra, luai_numsub(nvalue(ra), nvalue(pstep)));
+        if (ttisint(init) && ttisint(plimit) && ttisint(pstep) &&
+            intsub(ivalue(init), ivalue(pstep), ir)) {
+          setivalue(ra, ir);  /* integer loop */
+        }
+        else {
+          if (!tonumber(init, ra))
+            luaG_runerror(L, LUA_QL("for") " initial value must be a number");
+          else if (!tonumber(plimit, ra+1))
+            luaG_runerror(L, LUA_QL("for") " limit must be a number");
+          else if (!tonumber(pstep, ra+2))
+            luaG_runerror(L, LUA_QL("for") " step must be a number");
+          /* float loop: `OP_FORLOOP' expects all three to be floats */
+          setnvalue(ra+1, nvalue(ra+1));
+          setnvalue(ra+2, nvalue(ra+2));
+          setnvalue(ra, luai_numsub(nvalue(ra), nvalue(ra+2)));
+        }
         dojump(L, pc, GETARG_sBx(i));
-        continue;
+        vmbreak;
       }
-      case OP_TFORLOOP: {
+      vmcase(OP_TFORLOOP) {
         StkId cb = ra + 3;  /* call base */
+        int go;
+        Protect(go = tforloop(L, ra, GETARG_C(i)));
+        if (go > 0) {
+          dojump(L, pc, GETARG_sBx(*pc) + 1);  /* jump back (past the jump) */
+          vmloop();
+          vmbreak;
+        }
+        else if (go == 0) {
+          pc++;
+          vmbreak;
+        }
         setobjs2s(L, cb+2, ra+2);
         setobjs2s(L, cb+1, ra+1);
         setobjs2s(L, cb, ra);
@@ -695,12 +1351,14 @@ void luaV_execute (lua_State *L, int nexeccalls) {
         cb = RA(i) + 3;  /* previous call may change the stack */
         if (!ttisnil(cb)) {  /* continue loop? */
           setobjs2s(L, cb-1, cb);  /* save control variable */
-          dojump(L, pc, GETARG_sBx(*pc));  /* jump back */
+          dojump(L, pc, GETARG_sBx(*pc) + 1);  /* jump back (past the jump) */
+          vmloop();
         }
-        pc++;
-        continue;
+        else
+          pc++;
+        vmbreak;
       }
-      case OP_SETLIST: {
+      vmcase(OP_SETLIST) {
         int n = GETARG_B(i);
         int c = GETARG_C(i);
         int last;
@@ -713,20 +1371,20 @@ void luaV_execute (lua_State *L, int nexeccalls) {
         runtime_check(L, ttistable(ra));
         h = hvalue(ra);
         last = ((c-1)*LFIELDS_PER_FLUSH) + n;
-        if (last > h->sizearray)  /* needs more space? */
+        if (last > luaH_sizearray(h))  /* needs more space? */
           luaH_resizearray(L, h, last);  /* pre-alloc it at once */
         for (; n > 0; n--) {
           TValue *val = ra+n;
-          setobj2t(L, luaH_setnum(L, h, last--), val);
+          luaH_setint(L, h, last--, val);
           luaC_barriert(L, h, val);
         }
-        continue;
+        vmbreak;
       }
-      case OP_CLOSE: {
+      vmcase(OP_CLOSE) {
         luaF_close(L, ra);
-        continue;
+        vmbreak;
       }
-      case OP_CLOSURE: {
+      vmcase(OP_CLOSURE) {
         Proto *p;
         Closure *ncl;
         int nup, j;
@@ -750,9 +1408,29 @@ void luaV_execute (lua_State *L, int nexeccalls) {
         // 将创建好的closure存放到ra中
         setclvalue(L, ra, ncl);
         Protect(luaC_checkGC(L));
-        continue;
+        vmbreak;
+      }
+      vmcase(OP_EQK) {
+        TValue *rb = RB(i);
+        TValue *rc = KC(i);
+        /* constants have no metatables, so this is a raw equality */
+        if ((ttisint(rb) && ttisint(rc) ? ivalue(rb) == ivalue(rc) :
+             ttype(rb) == ttype(rc) &&
+             (ttisnumber(rb) ? luai_numeq(nvalue(rb), nvalue(rc))
+                             : luaO_rawequalObj(rb, rc))) == GETARG_A(i))
+          dojump(L, pc, GETARG_sBx(*pc));
+        pc++;
+        vmbreak;
+      }
+      vmcase(OP_ADDK) {
+        arithk_op(luai_numadd, intadd, TM_ADD, quicken(OP_ADDKF));
+        vmbreak;
       }
-      case OP_VARARG: {
+      vmcase(OP_SUBK) {
+        arithk_op(luai_numsub, intsub, TM_SUB, quicken(OP_SUBKF));
+        vmbreak;
+      }
+      vmcase(OP_VARARG) {
         int b = GETARG_B(i) - 1;
         int j;
         CallInfo *ci = L->ci;
@@ -771,9 +1449,356 @@ void luaV_execute (lua_State *L, int nexeccalls) {
             setnilvalue(ra + j);
           }
         }
-        continue;
+        vmbreak;
+      }
+      vmcase(OP_ADDF) {
+        farith_op(luai_numadd, intadd, TM_ADD, OP_ADD);
+        vmbreak;
+      }
+      vmcase(OP_SUBF) {
+        farith_op(luai_numsub, intsub, TM_SUB, OP_SUB);
+        vmbreak;
+      }
+      vmcase(OP_MULF) {
+        farith_op(luai_nummul, intmul, TM_MUL, OP_MUL);
+        vmbreak;
+      }
+      vmcase(OP_ADDKF) {
+        farithk_op(luai_numadd, intadd, TM_ADD, OP_ADDK);
+        vmbreak;
+      }
+      vmcase(OP_SUBKF) {
+        farithk_op(luai_numsub, intsub, TM_SUB, OP_SUBK);
+        vmbreak;
+      }
+      vmcase(OP_GETTABLEI) {
+        TValue *rb = RB(i);
+        TValue *rc = RKC(i);
+        if (ttistable(rb) && ttisint(rc))
+          gettableint(rb, rc)
+        else {
+          quicken(OP_GETTABLE);
+          Protect(luaV_gettable(L, rb, rc, ra));
+        }
+        vmbreak;
+      }
+      vmcase(OP_SETTABLEI) {
+        TValue *rb = RKB(i);
+        TValue *rc = RKC(i);
+        if (ttistable(ra) && ttisint(rb))
+          settableint(ra, rb, rc)
+        else {
+          quicken(OP_SETTABLE);
+          Protect(luaV_settable(L, ra, rb, rc));
+        }
+        vmbreak;
+      }
+    }
+  }
+#if defined(LUAI_JUMPTABLE)
+ L_hook:  /* every entry of `hooktab' lands here */
+  vmtrace();
+  ra = RA(i);
+  goto *disptab[GET_OPCODE(i)];
+#endif
+}
+
+
+/*
+** {======================================================
+** Instructions out of line, for compiled code (see ljit.c and laot.h);
+** the caller sets `L->savedpc' to the next instruction first
+** =======================================================
+*/
+
+#define xcl(L)		(&clvalue((L)->ci->func)->l)
+#define xcache(L,cl)	(&(cl)->p->icache[pcRel((L)->savedpc, (cl)->p)])
+#define XR(x)		(L->base + (x))
+#define XRK(x)		(ISK(x) ? xcl(L)->p->k + INDEXK(x) : L->base + (x))
+
+
+/* t[key] with the fast paths of `luaV_execute' */
+static void getfast (lua_State *L, const TValue *t, TValue *key, StkId ra) {
+  if (ttistable(t)) {
+    Table *h = hvalue(t);
+    const TValue *res;
+    if (ttisstring(key))
+      res = luaH_getstrfast(h, rawtsvalue(key), xcache(L, xcl(L)));
+    else
+      res = luaH_get(h, key);
+    if (!ttisnil(res) || fasttm(L, h->metatable, TM_INDEX) == NULL) {
+      setobj2s(L, ra, res);
+      return;
+    }
+  }
+  luaV_gettable(L, t, key, ra);
+}
+
+
+static void setfast (lua_State *L, const TValue *t, TValue *key, StkId val) {
+  if (ttistable(t) && ttisstring(key)) {
+    Table *h = hvalue(t);
+    TValue *slot = cast(TValue *,
+                        luaH_getstrfast(h, rawtsvalue(key), xcache(L, xcl(L))));
+    if (!ttisnil(slot) && !h->watched) {
+      setobj2t(L, slot, val);
+      luaC_barriert(L, h, val);
+      return;
+    }
+  }
+  else if (ttistable(t) && ttisint(key) &&
+           packedset(L, hvalue(t), ivalue(key), val))
+    return;
+  luaV_settable(L, t, key, val);
+}
+
+
+int luaV_opgetglobal (lua_State *L, Instruction i) {
+  LClosure *cl = xcl(L);
+  TValue g;
+  sethvalue(L, &g, cl->env);
+  getfast(L, &g, cl->p->k + GETARG_Bx(i), XR(GETARG_A(i)));
+  return 0;
+}
+
+
+int luaV_opsetglobal (lua_State *L, Instruction i) {
+  LClosure *cl = xcl(L);
+  TValue g;
+  sethvalue(L, &g, cl->env);
+  setfast(L, &g, cl->p->k + GETARG_Bx(i), XR(GETARG_A(i)));
+  return 0;
+}
+
+
+int luaV_opsetupval (lua_State *L, Instruction i) {
+  UpVal *uv = xcl(L)->upvals[GETARG_B(i)];
+  StkId ra = XR(GETARG_A(i));
+  setobj(L, uv->v, ra);
+  luaC_barrier(L, uv, ra);
+  return 0;
+}
+
+
+int luaV_opgettable (lua_State *L, Instruction i) {
+  getfast(L, XR(GETARG_B(i)), XRK(GETARG_C(i)), XR(GETARG_A(i)));
+  return 0;
+}
+
+
+int luaV_opsettable (lua_State *L, Instruction i) {
+  setfast(L, XR(GETARG_A(i)), XRK(GETARG_B(i)), XRK(GETARG_C(i)));
+  return 0;
+}
+
+
+int luaV_opnewtable (lua_State *L, Instruction i) {
+  int b = GETARG_B(i);
+  int c = GETARG_C(i);
+  sethvalue(L, XR(GETARG_A(i)), luaH_new(L, luaO_fb2int(b), luaO_fb2int(c)));
+  luaC_checkGC(L);
+  return 0;
+}
+
+
+int luaV_opself (lua_State *L, Instruction i) {
+  StkId ra = XR(GETARG_A(i));
+  StkId rb = XR(GETARG_B(i));
+  TValue *rc = XRK(GETARG_C(i));
+  setobjs2s(L, ra+1, rb);
+  if (!ttisstring(rc))
+    luaV_gettable(L, rb, rc, ra);
+  else {
+    if (ttistable(rb)) {
+      const TValue *res = luaH_getstrfast(hvalue(rb), rawtsvalue(rc),
+                                          xcache(L, xcl(L)));
+      if (!ttisnil(res)) {
+        setobj2s(L, ra, res);
+        return 0;
       }
     }
+    luaV_getmethod(L, rb, rc, ra);
+  }
+  return 0;
+}
+
+
+int luaV_oparith (lua_State *L, Instruction i) {
+  static const lu_byte events[] = {TM_ADD, TM_SUB, TM_MUL, TM_DIV, TM_MOD,
+                                   TM_POW, TM_UNM};
+  OpCode op = getBaseOp(GET_OPCODE(i));
+  StkId ra = XR(GETARG_A(i));
+  switch (op) {
+    case OP_ADDK: case OP_SUBK: {
+      luaV_arith(L, ra, XR(GETARG_B(i)), XRK(GETARG_C(i)),
+                 op == OP_ADDK ? TM_ADD : TM_SUB);
+      break;
+    }
+    case OP_UNM: {
+      luaV_arith(L, ra, XR(GETARG_B(i)), XR(GETARG_B(i)), TM_UNM);
+      break;
+    }
+    default: {
+      lua_assert(OP_ADD <= op && op <= OP_POW);
+      luaV_arith(L, ra, XRK(GETARG_B(i)), XRK(GETARG_C(i)),
+                 cast(TMS, events[op - OP_ADD]));
+      break;
+    }
+  }
+  return 0;
+}
+
+
+int luaV_opnot (lua_State *L, Instruction i) {
+  int res = l_isfalse(XR(GETARG_B(i)));
+  setbvalue(XR(GETARG_A(i)), res);
+  return 0;
+}
+
+
+int luaV_oplen (lua_State *L, Instruction i) {
+  luaV_objlen(L, XR(GETARG_A(i)), XR(GETARG_B(i)));
+  return 0;
+}
+
+
+int luaV_opconcat (lua_State *L, Instruction i) {
+  int b = GETARG_B(i);
+  int c = GETARG_C(i);
+  luaV_concat(L, c-b+1, c);
+  luaC_checkGC(L);
+  setobjs2s(L, XR(GETARG_A(i)), XR(b));
+  return 0;
+}
+
+
+int luaV_opeq (lua_State *L, Instruction i) {
+  TValue *rb = XRK(GETARG_B(i));
+  TValue *rc = XRK(GETARG_C(i));
+  return equalobj(L, rb, rc);
+}
+
+
+int luaV_opeqk (lua_State *L, Instruction i) {
+  TValue *rb = XR(GETARG_B(i));
+  TValue *rc = XRK(GETARG_C(i));
+  if (ttisint(rb) && ttisint(rc))
+    return ivalue(rb) == ivalue(rc);
+  return ttype(rb) == ttype(rc) &&
+         (ttisnumber(rb) ? luai_numeq(nvalue(rb), nvalue(rc))
+                         : luaO_rawequalObj(rb, rc));
+}
+
+
+int luaV_oplt (lua_State *L, Instruction i) {
+  return luaV_lessthan(L, XRK(GETARG_B(i)), XRK(GETARG_C(i)));
+}
+
+
+int luaV_ople (lua_State *L, Instruction i) {
+  return luaV_lessequal(L, XRK(GETARG_B(i)), XRK(GETARG_C(i)));
+}
+
+
+int luaV_optestset (lua_State *L, Instruction i) {
+  TValue *rb = XR(GETARG_B(i));
+  if (l_isfalse(rb) != GETARG_C(i)) {
+    setobjs2s(L, XR(GETARG_A(i)), rb);
+    return 1;
+  }
+  return 0;
+}
+
+
+int luaV_opforprep (lua_State *L, Instruction i) {
+  StkId ra = XR(GETARG_A(i));
+  const TValue *init = ra;
+  const TValue *plimit = ra+1;
+  const TValue *pstep = ra+2;
+  if (ttisint(init) && ttisint(plimit) && ttisint(pstep)) {
+    int idx = ivalue(init), step = ivalue(pstep);
+    int r = cast_int(cast(unsigned int, idx) - cast(unsigned int, step));
+    if (((idx ^ step) & (idx ^ r)) >= 0) {  /* no overflow? */
+      setivalue(ra, r);  /* integer loop */
+      return 0;
+    }
+  }
+  if (!tonumber(init, ra))
+    luaG_runerror(L, LUA_QL("for") " initial value must be a number");
+  else if (!tonumber(plimit, ra+1))
+    luaG_runerror(L, LUA_QL("for") " limit must be a number");
+  else if (!tonumber(pstep, ra+2))
+    luaG_runerror(L, LUA_QL("for") " step must be a number");
+  setnvalue(ra+1, nvalue(ra+1));
+  setnvalue(ra+2, nvalue(ra+2));
+  setnvalue(ra, luai_numsub(nvalue(ra), nvalue(ra+2)));
+  return 0;
+}
+
+
+int luaV_optforloop (lua_State *L, Instruction i) {
+  StkId cb = XR(GETARG_A(i)) + 3;  /* call base */
+  int go = tforloop(L, cb - 3, GETARG_C(i));
+  if (go >= 0)
+    return go;
+  setobjs2s(L, cb+2, cb-1);
+  setobjs2s(L, cb+1, cb-2);
+  setobjs2s(L, cb, cb-3);
+  L->top = cb+3;  /* func. + 2 args (state and index) */
+  luaD_call(L, cb, GETARG_C(i));
+  L->top = L->ci->top;
+  cb = XR(GETARG_A(i)) + 3;  /* previous call may change the stack */
+  if (!ttisnil(cb)) {  /* continue loop? */
+    setobjs2s(L, cb-1, cb);  /* save control variable */
+    return 1;
+  }
+  return 0;
+}
+
+
+int luaV_opsetlist (lua_State *L, Instruction i) {
+  StkId ra = XR(GETARG_A(i));
+  int n = GETARG_B(i);
+  int c = GETARG_C(i);
+  int last;
+  Table *h;
+  if (n == 0) {
+    n = cast_int(L->top - ra) - 1;
+    L->top = L->ci->top;
   }
+  if (c == 0) c = cast_int(*L->savedpc);
+  if (!ttistable(ra)) return 0;
+  h = hvalue(ra);
+  last = ((c-1)*LFIELDS_PER_FLUSH) + n;
+  if (last > luaH_sizearray(h))  /* needs more space? */
+    luaH_resizearray(L, h, last);  /* pre-alloc it at once */
+  for (; n > 0; n--) {
+    TValue *val = ra+n;
+    luaH_setint(L, h, last--, val);
+    luaC_barriert(L, h, val);
+  }
+  return 0;
+}
+
+
+/*
+** OP_CALL with B and C not 0, when `callfast' can do it; 1 if done, else
+** 0 with the call left to `luaV_execute'
+*/
+int luaV_opcall (lua_State *L, Instruction i) {
+  StkId ra = XR(GETARG_A(i));
+  L->top = ra + GETARG_B(i);
+  if (isfastcall(ra) &&
+      callfast(L, ra, GETARG_B(i) - 1, GETARG_C(i) - 1, xcache(L, xcl(L))))
+    return 1;
+  L->top = L->ci->top;
+  return 0;
+}
+
+
+int luaV_opclose (lua_State *L, Instruction i) {
+  luaF_close(L, XR(GETARG_A(i)));
+  return 0;
 }
 
+/* }====================================================== */
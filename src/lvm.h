@@ -21,8 +21,50 @@
 #define equalobj(L,o1,o2) \
 	(ttype(o1) == ttype(o2) && luaV_equalval(L, o1, o2))
 
+/*
+** to be done before a write to table `t' (or to its metatable field); see
+** `luaV_getmethod' and `luaH_freeze'
+*/
+#define luaV_touch(L,t)	{ if ((t)->watched) luaV_touched(L, t); }
+
+
+/*
+** Arithmetic on the integer subtype. Each operation leaves its result
+** in `r' and fails when that result is not an int (overflow, or a -0
+** from a multiplication); the caller then computes it with lua_Numbers,
+** which gives exactly the value Lua always produced.
+*/
+#define intadd(a,b,r)	((r) = cast_int(cast(unsigned int, a) + \
+                                cast(unsigned int, b)), \
+                         (((a) ^ (r)) & ((b) ^ (r))) >= 0)
+#define intsub(a,b,r)	((r) = cast_int(cast(unsigned int, a) - \
+                                cast(unsigned int, b)), \
+                         (((a) ^ (b)) & ((a) ^ (r))) >= 0)
+#if defined(__GNUC__) && __GNUC__ >= 5
+#define intmul(a,b,r)	(!__builtin_mul_overflow(a, b, &(r)) && \
+                         ((r) != 0 || ((a) | (b)) >= 0))
+#else
+#define intmul(a,b,r)	((-46340 <= (a) && (a) <= 46340 && \
+                          -46340 <= (b) && (b) <= 46340) ? \
+                         ((r) = (a) * (b), (r) != 0 || ((a) | (b)) >= 0) : \
+                         luaV_intmul(a, b, &(r)))
+#endif
+#define intmod(a,b,r)	((b) != 0 && (b) != -1 && \
+                         ((r) = (a) % (b), \
+                          ((r) != 0 && ((r) ^ (b)) < 0) ? ((r) += (b)) : 0, 1))
+#define intnone(a,b,r)	0
+
+
+/*
+** the inline cache of an OP_CALL tells how the last call made without a
+** CallInfo went: the builtin computed (LUA_INTRABS & co.) or CALL_FASTC
+** for the fast version of a C function (see `callfast'); 0 if none
+*/
+#define CALL_FASTC	(-1)
+
 
 LUAI_FUNC int luaV_lessthan (lua_State *L, const TValue *l, const TValue *r);
+LUAI_FUNC int luaV_lessequal (lua_State *L, const TValue *l, const TValue *r);
 LUAI_FUNC int luaV_equalval (lua_State *L, const TValue *t1, const TValue *t2);
 LUAI_FUNC const TValue *luaV_tonumber (const TValue *obj, TValue *n);
 LUAI_FUNC int luaV_tostring (lua_State *L, StkId obj);
@@ -32,5 +74,36 @@ LUAI_FUNC void luaV_settable (lua_State *L, const TValue *t, TValue *key,
                                             StkId val);
 LUAI_FUNC void luaV_execute (lua_State *L, int nexeccalls);
 LUAI_FUNC void luaV_concat (lua_State *L, int total, int last);
+LUAI_FUNC void luaV_arith (lua_State *L, StkId ra, const TValue *rb,
+                           const TValue *rc, TMS op);
+LUAI_FUNC void luaV_objlen (lua_State *L, StkId ra, const TValue *rb);
+LUAI_FUNC int luaV_intmul (int a, int b, int *r);
+LUAI_FUNC void luaV_getmethod (lua_State *L, const TValue *t, TValue *key,
+                                             StkId val);
+LUAI_FUNC void luaV_newversion (global_State *g);
+LUAI_FUNC void luaV_touched (lua_State *L, Table *t);
+
+/* instructions out of line (see lvm.c) */
+LUAI_FUNC int luaV_opgetglobal (lua_State *L, Instruction i);
+LUAI_FUNC int luaV_opsetglobal (lua_State *L, Instruction i);
+LUAI_FUNC int luaV_opsetupval (lua_State *L, Instruction i);
+LUAI_FUNC int luaV_opgettable (lua_State *L, Instruction i);
+LUAI_FUNC int luaV_opsettable (lua_State *L, Instruction i);
+LUAI_FUNC int luaV_opnewtable (lua_State *L, Instruction i);
+LUAI_FUNC int luaV_opself (lua_State *L, Instruction i);
+LUAI_FUNC int luaV_oparith (lua_State *L, Instruction i);
+LUAI_FUNC int luaV_opnot (lua_State *L, Instruction i);
+LUAI_FUNC int luaV_oplen (lua_State *L, Instruction i);
+LUAI_FUNC int luaV_opconcat (lua_State *L, Instruction i);
+LUAI_FUNC int luaV_opeq (lua_State *L, Instruction i);
+LUAI_FUNC int luaV_opeqk (lua_State *L, Instruction i);
+LUAI_FUNC int luaV_oplt (lua_State *L, Instruction i);
+LUAI_FUNC int luaV_ople (lua_State *L, Instruction i);
+LUAI_FUNC int luaV_optestset (lua_State *L, Instruction i);
+LUAI_FUNC int luaV_opforprep (lua_State *L, Instruction i);
+LUAI_FUNC int luaV_optforloop (lua_State *L, Instruction i);
+LUAI_FUNC int luaV_opsetlist (lua_State *L, Instruction i);
+LUAI_FUNC int luaV_opcall (lua_State *L, Instruction i);
+LUAI_FUNC int luaV_opclose (lua_State *L, Instruction i);
 
 #endif
@@ -128,6 +128,9 @@ static void PrintCode(const Proto* f)
    case OP_EQ:
    case OP_LT:
    case OP_LE:
+   case OP_EQK:
+   case OP_ADDK:
+   case OP_SUBK:
     if (ISK(b) || ISK(c))
     {
      printf("\t; ");
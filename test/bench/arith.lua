@@ -0,0 +1,8 @@
+-- numeric for loops and arithmetic: OP_FORLOOP, OP_ADD, OP_MUL, OP_MOD
+local t0 = os.clock()
+local s, x = 0, 1.5
+for i = 1, 1.5e7 do
+  s = s + i * 2 - i % 7
+  x = x * 0.999 + 1
+end
+print(os.clock() - t0)
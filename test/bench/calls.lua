@@ -0,0 +1,14 @@
+-- method calls: OP_SELF, OP_CALL, OP_RETURN
+local Point = {}
+Point.__index = Point
+function Point.new(x, y) return setmetatable({x = x, y = y}, Point) end
+function Point:getx() return self.x end
+function Point:move(dx) self.x = self.x + dx return self end
+
+local p = Point.new(0, 0)
+local t0 = os.clock()
+for i = 1, 5e6 do
+  p:move(1)
+  p:getx()
+end
+print(os.clock() - t0)
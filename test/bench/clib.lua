@@ -0,0 +1,10 @@
+-- calls of C library functions: OP_CALL into C
+local floor, sub, max = math.floor, string.sub, math.max
+local s = "abcdefgh"
+local t0 = os.clock()
+for i = 1, 5e6 do
+  local a = floor(i / 3)
+  local b = sub(s, 2, 4)
+  local c = max(a, i)
+end
+print(os.clock() - t0)
@@ -0,0 +1,8 @@
+-- recursive calls: OP_LT, OP_SUB, OP_CALL, OP_RETURN
+local function fib(n)
+  if n < 2 then return n end
+  return fib(n - 1) + fib(n - 2)
+end
+local t0 = os.clock()
+fib(32)
+print(os.clock() - t0)
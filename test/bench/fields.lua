@@ -0,0 +1,9 @@
+-- field access: OP_GETTABLE, OP_SETTABLE with constant keys, OP_GETGLOBAL
+local o = {a = 1, b = 2, c = 3}
+counter = 0
+local t0 = os.clock()
+for i = 1, 1e7 do
+  o.a = o.b + o.c
+  o.c = o.a - counter
+end
+print(os.clock() - t0)
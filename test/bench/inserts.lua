@@ -0,0 +1,9 @@
+-- table inserts: OP_NEWTABLE, OP_SETTABLE, OP_LEN
+local t0 = os.clock()
+for r = 1, 100 do
+  local t = {}
+  for i = 1, 5e4 do t[#t + 1] = i end
+  local h = {}
+  for i = 1, 5e3 do h["k" .. (i % 100)] = i end
+end
+print(os.clock() - t0)
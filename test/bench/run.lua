@@ -0,0 +1,47 @@
+-- runs each opcode mix with the given interpreters and prints the best
+-- CPU time of each, and how much faster or slower than the first one
+-- usage: lua run.lua [-n runs] lua1 lua2 ...   (from this directory)
+
+local mixes = {"calls", "inserts", "arith", "fields", "fib", "clib",
+               "builtins"}
+local runs = 7
+local bins = {}
+local i = 1
+while arg[i] do
+  if arg[i] == "-n" then runs = tonumber(arg[i + 1]); i = i + 2
+  else bins[#bins + 1] = arg[i]; i = i + 1 end
+end
+if #bins == 0 then
+  io.stderr:write("usage: lua run.lua [-n runs] lua1 lua2 ...\n")
+  os.exit(1)
+end
+
+local function best (bin, mix)
+  local b
+  for r = 1, runs do
+    local f = assert(io.popen(bin .. " " .. mix .. ".lua"))
+    local t = tonumber(f:read("*l"))
+    f:close()
+    assert(t, bin .. " failed on " .. mix)
+    if not b or t < b then b = t end
+  end
+  return b
+end
+
+io.write(string.format("%-10s", "mix"))
+for _, bin in ipairs(bins) do io.write(string.format("%22s", bin)) end
+io.write("\n")
+for _, mix in ipairs(mixes) do
+  io.write(string.format("%-10s", mix))
+  local base
+  for j, bin in ipairs(bins) do
+    local t = best(bin, mix)
+    if j == 1 then
+      base = t
+      io.write(string.format("%22.3f", t))
+    else
+      io.write(string.format("%14.3f %+6.1f%%", t, (t - base) / base * 100))
+    end
+  end
+  io.write("\n")
+end
@@ -0,0 +1,58 @@
+-- lib.name(args) must fetch lib.name before it evaluates args, as any
+-- other call does, also when OP_CALL computes it inline (lua_setintrinsic)
+-- usage: lua test/callorder.lua
+
+local floor, sqrt, byte = math.floor, math.sqrt, string.byte
+
+-- the function is replaced while the arguments are evaluated
+local function g() math.floor = function() return "new" end return 1.5 end
+assert(math.floor(g()) == 1)
+assert(math.floor(1.5) == "new")
+math.floor = floor
+
+-- the library is replaced while the arguments are evaluated
+local function h() math = {sqrt = function() return "new" end} return 4 end
+local m = math
+assert(math.sqrt(h()) == 2)
+assert(math.sqrt(4) == "new")
+math = m
+
+-- the same in a tail call and with several arguments
+local function t() return math.floor(g()) end
+assert(t() == 1)
+math.floor = floor
+local function k() string.byte = nil return 2 end
+assert(string.byte("abc", k()) == 98)
+string.byte = byte
+
+-- a library reached through __index is indexed before the arguments
+local log = {}
+local lib = setmetatable({}, {__index = function(_, name)
+  log[#log+1] = "index " .. name
+  return function(x) return x end
+end})
+local function arg() log[#log+1] = "arg" return 7 end
+_G.mylib = lib
+assert(mylib.floor(arg()) == 7)
+assert(log[1] == "index floor" and log[2] == "arg")
+_G.mylib = nil
+log = {}
+math = setmetatable({}, {__index = function(_, name)
+  log[#log+1] = "index " .. name
+  return floor
+end})
+assert(math.floor(arg()) == 7)
+assert(log[1] == "index floor" and log[2] == "arg")
+math = m
+
+-- hot loops still get the builtins, and notice a replacement
+local s = 0
+for i = 1, 1000 do s = s + math.floor(i / 2) + byte("a") end
+assert(s == 250000 + 97000)
+for i = 1, 10 do
+  if i == 5 then math.sqrt = function() return 0 end end
+  assert(math.sqrt(i * i) == (i < 5 and i or 0))
+end
+math.sqrt = sqrt
+
+print("OK")
@@ -0,0 +1,113 @@
+-- table.freeze makes a table read-only for every way of writing to it,
+-- and keeps its lookups working
+-- usage: lua test/freeze.lua
+
+local function frozen(f, ...)
+  local ok, e = pcall(f, ...)
+  assert(not ok and string.find(e, "attempt to modify a frozen table", 1, true),
+         e)
+end
+
+local key = {}
+local function fill()
+  local t = {10, 20, 30, x = 1, y = "two", [2.5] = "half", [true] = "yes",
+             [key] = "table", [100] = "far", [-1] = "neg"}
+  for i = 1, 50 do t["k" .. i] = i end
+  for i = 1, 50, 2 do t["k" .. i] = nil end  -- dead keys in the hash part
+  return t
+end
+
+local function check(t)
+  assert(t[1] == 10 and t[2] == 20 and t[3] == 30 and t[4] == nil)
+  assert(t.x == 1 and t.y == "two" and t[2.5] == "half" and t[true] == "yes")
+  assert(t[key] == "table" and t[100] == "far" and t[-1] == "neg")
+  for i = 1, 50 do assert(t["k" .. i] == (i % 2 == 0 and i or nil)) end
+  assert(t.nothere == nil and t[false] == nil and t[{}] == nil)
+  local n = 0
+  for k, v in pairs(t) do assert(t[k] == v); n = n + 1 end
+  assert(n == 3 + 7 + 25)
+  assert(#t == 3)
+end
+
+local t = fill()
+assert(table.freeze(t) == t)
+check(t)  -- the hash part was rebuilt
+
+-- every write raises, and leaves the table as it was
+frozen(function() t.x = 2 end)
+frozen(function() t.new = 1 end)
+frozen(function() t[1] = 0 end)
+frozen(function() t[4] = 40 end)
+frozen(function() t.x = nil end)
+frozen(rawset, t, "x", 2)
+frozen(rawset, t, "new", 1)
+frozen(rawset, t, 1, 0)
+frozen(rawset, t, 4, 40)  -- the C API's lua_rawseti through table.insert
+frozen(table.insert, t, 40)
+frozen(table.insert, t, 1, 0)
+frozen(table.remove, t)
+frozen(table.remove, t, 1)
+frozen(table.sort, t, function(a, b) return a > b end)
+frozen(table.clear, t)
+frozen(setmetatable, t, {})
+frozen(setmetatable, t, nil)
+check(t)
+for i = 1, 100 do  -- also from hot code
+  assert(not pcall(function() t.x = i end))
+  assert(not pcall(function() t[1] = i end))
+end
+check(t)
+-- table.remove and table.sort of what has nothing to move do not write
+assert(table.remove(table.freeze({})) == nil)
+table.sort(table.freeze({1}))
+
+-- a metatable set before freezing still works, and cannot be changed
+local log = {}
+local m = table.freeze(setmetatable({a = 1}, {
+  __index = function(_, k) return k .. "!" end,
+  __newindex = function(_, k) log[#log + 1] = k end,
+}))
+assert(m.a == 1 and m.b == "b!")
+frozen(function() m.a = 2 end)
+frozen(function() m.c = 3 end)  -- no new keys, __newindex or not
+assert(#log == 0 and rawget(m, "c") == nil)
+frozen(setmetatable, m, nil)
+assert(getmetatable(m).__index ~= nil)
+
+-- clones are writable
+local c = table.clone(t)
+c.x = 2; c.new = 1; c[1] = 0; c[4] = 40
+rawset(c, "y", 3)
+table.insert(c, 50)
+table.remove(c, 1)
+table.sort(c)
+setmetatable(c, {})
+table.clear(c)
+assert(next(c) == nil)
+local d = table.clone({t}, true)
+d[1].x = 5
+assert(d[1].x == 5 and t.x == 1)
+check(t)
+
+-- table.compact skips frozen tables: no memory is freed or taken
+local big = {}
+for i = 1, 1000 do big["k" .. i] = i end
+for i = 1, 990 do big["k" .. i] = nil end
+table.freeze(big)
+collectgarbage("stop")
+local before = collectgarbage("count")
+table.compact(big)
+assert(collectgarbage("count") == before)
+collectgarbage("restart")
+for i = 991, 1000 do assert(big["k" .. i] == i) end
+frozen(function() big.k1000 = 0 end)
+table.compact(t)
+check(t)
+
+-- freezing twice is harmless, and frozen tables survive collections
+assert(table.freeze(t) == t)
+collectgarbage()
+check(t)
+frozen(function() t.x = 2 end)
+
+print("OK")
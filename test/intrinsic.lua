@@ -0,0 +1,124 @@
+-- calls of the builtins (see lua_setintrinsic) computed inline must give
+-- what calling the C functions gives, and must notice replacements and
+-- call hooks
+-- usage: lua test/intrinsic.lua
+
+local function same(x, y)
+  if x ~= x then return y ~= y end  -- nan
+  if x == 0 and y == 0 then return 1/x == 1/y end  -- -0
+  return x == y
+end
+
+-- pcall calls the C function itself
+local function check(f, r, ...)
+  local ok, e = pcall(f, ...)
+  assert(ok and same(r, e), tostring(r) .. " ~= " .. tostring(e))
+end
+
+local nums = {0, -0.0, 1, -1, 0.5, -0.5, 2.5, -2.5, 3, 1e300, -1e300,
+              2^31, -2^31, 2147483647, -2147483648, 1/0, -1/0, 0/0,
+              1e-310, math.pi}
+
+local fs = {math.abs, math.ceil, math.floor, math.sqrt, math.sin, math.cos,
+            math.exp, math.log, math.fmod, math.min, math.max}
+
+-- the calls in a loop of their own, so that compiled code (if any) does
+-- them too
+local function inline (r)
+  for j = 1, #nums do
+    local x = nums[j]
+    local y = nums[(j * 7) % #nums + 1]
+    local k = (j - 1) * 13
+    r[k + 1] = math.abs(x)
+    r[k + 2] = math.ceil(x)
+    r[k + 3] = math.floor(x)
+    r[k + 4] = math.sqrt(x)
+    r[k + 5] = math.sin(x)
+    r[k + 6] = math.cos(x)
+    r[k + 7] = math.exp(x)
+    r[k + 8] = math.log(x)
+    r[k + 9] = math.fmod(x, y)
+    r[k + 10] = math.min(x, y)
+    r[k + 11] = math.max(x, y)
+    r[k + 12] = math.min(y, x)
+    r[k + 13] = math.max(y, x)
+  end
+end
+
+for rep = 1, 100 do
+  local r = {}
+  inline(r)
+  for j = 1, #nums do
+    local x = nums[j]
+    local y = nums[(j * 7) % #nums + 1]
+    local k = (j - 1) * 13
+    for n = 1, 8 do check(fs[n], r[k + n], x) end
+    check(math.fmod, r[k + 9], x, y)
+    check(math.min, r[k + 10], x, y)
+    check(math.max, r[k + 11], x, y)
+    check(math.min, r[k + 12], y, x)
+    check(math.max, r[k + 13], y, x)
+  end
+end
+
+local strs = {"", "a", "hello", "\0\255x"}
+
+local function bytes (r, s)
+  for i = -5, 5 do
+    r[#r + 1] = string.len(s)
+    r[#r + 1] = string.byte(s, i) or false
+    r[#r + 1] = s:byte(i + 0.5) or false
+  end
+end
+
+for rep = 1, 100 do
+  for j = 1, #strs do
+    local s, r = strs[j], {}
+    bytes(r, s)
+    for i = -5, 5 do
+      local k = (i + 5) * 3
+      check(string.len, r[k + 1], s)
+      assert(r[k + 2] == (select(2, pcall(string.byte, s, i)) or false))
+      assert(r[k + 3] == (select(2, pcall(string.byte, s, i + 0.5)) or false))
+    end
+  end
+end
+
+-- arguments the builtins do not take go to the C functions
+assert(math.floor("2.5") == 2 and math.max("3", 2) == 3)
+assert(string.len(12) == 2 and string.byte(12, 1) == 49)
+assert(not pcall(math.floor) and not pcall(math.sqrt, {}))
+assert(math.min(3, 1, 2) == 1 and math.max(1, 3, 2) == 3)
+assert(select('#', string.byte("abc", 10)) == 0)
+
+-- results are adjusted as for any call
+local a, b, c = math.floor(1.5)
+assert(a == 1 and b == nil and c == nil)
+local t = {math.sqrt(4), math.sqrt(9)}
+assert(t[1] == 2 and t[2] == 3)
+
+-- a replacement is called, wherever it is
+local floor, sqrt = math.floor, math.sqrt
+local s = 0
+for i = 1, 200 do
+  if i == 100 then math.floor = function(x) return -x end end
+  if i == 150 then math.floor = math.ceil end
+  s = s + math.floor(i + 0.5)
+end
+assert(s == 4950 - 6250 + 8976)
+math.floor = floor
+local r = {}
+for i = 1, 200 do
+  local f = i <= 100 and sqrt or function() return "lua" end
+  r[i] = f(4)
+end
+assert(r[1] == 2 and r[100] == 2 and r[101] == "lua" and r[200] == "lua")
+
+-- call hooks see the calls
+local calls = 0
+debug.sethook(function() calls = calls + 1 end, "c")
+for i = 1, 10 do local _ = math.floor(i / 2) + string.byte("a") end
+debug.sethook()
+assert(calls >= 20)
+
+print("OK")
@@ -0,0 +1,55 @@
+-- generic for over next and pairs, which OP_TFORLOOP steps inline, must
+-- behave as calling next: same keys, same errors, same tracebacks, hooks
+-- usage: lua test/next.lua
+
+-- an invalid control key is an error of next itself
+local ok, e = pcall(function() for k, v in next, {}, "nokey" do end end)
+assert(not ok and e == "invalid key to 'next'", e)
+local t = {10, 20, x = 1}
+ok, e = pcall(function() for k in next, t, 99 do end end)
+assert(not ok and e == "invalid key to 'next'", e)
+local tb = select(2, xpcall(function() for k in next, {}, {} do end end,
+                            debug.traceback))
+assert(string.find(tb, "[C]: in function '(for generator)'", 1, true), tb)
+
+-- a valid control key that is not the last one returned
+for _, start in ipairs{"x", 1, 2} do
+  local expect, got = {}, {}
+  local k = next(t, start)
+  while k ~= nil do expect[#expect + 1] = k; k = next(t, k) end
+  for k, v in next, t, start do
+    assert(t[k] == v)
+    got[#got + 1] = k
+  end
+  assert(#got == #expect)
+  for i = 1, #got do assert(got[i] == expect[i]) end
+end
+
+-- all keys, once each, also when fields are cleared on the way and
+-- when two traversals of the table are interleaved
+local big = {}
+for i = 1, 100 do big[i] = i; big["k" .. i] = i end
+local n = 0
+for k, v in pairs(big) do
+  n = n + 1
+  if type(k) == "string" then big[k] = nil end
+end
+assert(n == 200 and next(big, 100) == nil)
+for i = 1, 100 do big["k" .. i] = i end
+local k1, k2 = nil, nil
+repeat
+  local k
+  k1 = next(big, k1)
+  for key in next, big, k2 do k = key; break end
+  k2 = k
+  assert(k1 == k2)
+until k1 == nil
+
+-- call hooks see every call of the iterator
+local calls = 0
+debug.sethook(function() calls = calls + 1 end, "c")
+for k in pairs{1, 2, 3} do end
+debug.sethook()
+assert(calls >= 4)
+
+print("OK")